@@ -0,0 +1,285 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "app_config.h"
+#include "app_tools.h"
+#include "dsp.h"
+#include "color.h"
+#include "lights.h"
+#include "led_i2s.h"
+#include "web.h"
+
+
+/* each case repeated until it runs at least this long */
+#define BENCH_MIN_NS 200000000ULL
+#define BENCH_PIXEL_N 300
+#define BENCH_PACKET_SIZE 4096 // android A2DP packet
+
+
+typedef struct {
+    const char *name;
+    void (*fn)();
+    size_t item_n; // items (e.g. pixels) per iteration, 0: no throughput column
+} bench_case;
+
+
+static uint64_t bench_now();
+static void bench_run(const bench_case *bench);
+static void bench_color_hsl_to_rgb();
+static void bench_color_hsl_to_rgb_px();
+static void bench_color_hsl_fix_to_rgb_n();
+static void bench_dsp_new_data();
+static void bench_dsp_fft();
+static void bench_lights_main_fft();
+static void bench_lights_main_fft_apa102();
+static void bench_mled_i2s_encode();
+static void bench_web_ws_handshake();
+static void bench_web_ws_audio_meter();
+
+
+static const bench_case benches[] = {
+    {"color_hsl_to_rgb", bench_color_hsl_to_rgb},
+    {"color_hsl_to_rgb/300px", bench_color_hsl_to_rgb_px, BENCH_PIXEL_N},
+    {"color_hsl_fix_to_rgb_n/300px", bench_color_hsl_fix_to_rgb_n, BENCH_PIXEL_N},
+    {"dsp_new_data/4096B", bench_dsp_new_data},
+    {"dsp_fft", bench_dsp_fft},
+    {"lights_main/fft_300px", bench_lights_main_fft},
+    {"lights_main/fft_300px_apa102", bench_lights_main_fft_apa102},
+    {"mled_i2s_encode/300px", bench_mled_i2s_encode, BENCH_PIXEL_N * MLED_I2S_LANE_N},
+    {"web_ws/handshake", bench_web_ws_handshake},
+    {"web_ws/audio_meter", bench_web_ws_audio_meter}
+};
+static const char *TAGE = LOG_COLOR("92") "BENCH" LOG_COLOR_E;
+/* results go here, stdout is muted, the modules print there */
+static FILE *out = NULL;
+static volatile uint32_t sink = 0;
+static uint8_t packet[BENCH_PACKET_SIZE];
+static color_hsl px_hsl[BENCH_PIXEL_N];
+static color_hsl_fix px_hsl_fix[BENCH_PIXEL_N];
+static color_rgb px_rgb[BENCH_PIXEL_N];
+/* the strips of the parallel output, a lane each */
+static mled_strip i2s_strips[MLED_I2S_LANE_N];
+static uint8_t i2s_pixels[MLED_I2S_LANE_N][BENCH_PIXEL_N * 3];
+static mled_i2s_slot i2s_buf[MLED_I2S_SLOT_N(BENCH_PIXEL_N * 3)];
+static color_hsl fft_colors[] = {
+    {.hue = 0, .sat = 1.0f, .lum = 0.5f},
+    {.hue = 240, .sat = 1.0f, .lum = 0.5f}
+};
+
+
+int main(int argc, char *argv[])
+{
+    /* optional filter: only the cases containing it */
+    const char *filter = (argc > 1) ? argv[1] : "";
+    out = fdopen(dup(STDOUT_FILENO), "w");
+
+    if(!out || !freopen("/dev/null", "w", stdout)) return 1;
+
+    sim_start("bench", 1);
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    /* a rainbow with a lightness ramp, like a dimmed FFT zone */
+    for(size_t i = 0; i < BENCH_PIXEL_N; i++)
+    {
+        px_hsl[i] = (color_hsl) {.hue = (360.0f * i) / BENCH_PIXEL_N, .sat = 1.0f, .lum = (0.5f * i) / BENCH_PIXEL_N};
+        px_hsl_fix[i] = color_hsl_to_fix(px_hsl[i]);
+    }
+
+    /* stereo sine with some harmonics, the FFT and the lights have something to show */
+    int16_t *frame = (int16_t*)packet;
+
+    for(size_t i = 0; i < (BENCH_PACKET_SIZE / (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N)); i++)
+    {
+        float t = i / (float)AUDIO_SAMPLE_RATE;
+        frame[0] = frame[1] = 8000.0f * (sinf(2 * M_PI * 110 * t) + 0.5f * sinf(2 * M_PI * 2200 * t));
+        frame += AUDIO_CHANNEL_N;
+    }
+
+    ERR_CHECK_RESET(!dsp_fft_buf_create());
+
+    for(size_t i = 0; i < (DSP_FFT_BUF_N / BENCH_PACKET_SIZE); i++)
+    {
+        dsp_new_data(packet, sizeof(packet));
+    }
+
+    dsp_fft_do();
+    dsp_fft_finalize();
+    /* one FFT zone on the whole first strip */
+    mled_channels[0].rgb_order = (mled_rgb_order) {.i_r = 1, .i_g = 0, .i_b = 2};
+    lights_set_strip_size(0, BENCH_PIXEL_N);
+    lights_zone_chain *zone = lights_new_zone(0, BENCH_PIXEL_N);
+    ERR_IF_NULL_RESET(zone);
+    zone->shader.type = SHADER_FFT;
+    zone->shader.cfg.shader_fft = (lights_shader_cfg_fft) {
+        .colors = fft_colors,
+        .color_n = sizeof(fft_colors) / sizeof(fft_colors[0]),
+        .intensity = 1.0f
+    };
+    lights_shader_init_fft(zone);
+    /* the same on the second strip, a clocked one */
+    mled_channels[1].type = MLED_TYPE_APA102;
+    mled_channels[1].rgb_order = (mled_rgb_order) {.i_r = 2, .i_g = 1, .i_b = 0};
+    lights_set_strip_size(1, BENCH_PIXEL_N);
+    zone = lights_new_zone(1, BENCH_PIXEL_N);
+    ERR_IF_NULL_RESET(zone);
+    zone->shader.type = SHADER_FFT;
+    zone->shader.cfg.shader_fft = (lights_shader_cfg_fft) {
+        .colors = fft_colors,
+        .color_n = sizeof(fft_colors) / sizeof(fft_colors[0]),
+        .intensity = 1.0f
+    };
+    lights_shader_init_fft(zone);
+    /* random full strips to the parallel output, a lane each
+     * (the bit layout is checked by the tests) */
+    srand(1);
+
+    for(size_t lane = 0; lane < MLED_I2S_LANE_N; lane++)
+    {
+        for(size_t i = 0; i < (BENCH_PIXEL_N * 3); i++)
+        {
+            i2s_pixels[lane][i] = rand();
+        }
+
+        i2s_strips[lane].pixels.sent = i2s_pixels[lane];
+        i2s_strips[lane].pixels.pixel_n = BENCH_PIXEL_N;
+        i2s_strips[lane].pixels.data_size = BENCH_PIXEL_N * 3;
+    }
+
+    mled_i2s_frame_init(i2s_buf, BENCH_PIXEL_N * 3);
+
+    fprintf(out, "%-32s %14s %12s %10s\n", "Benchmark", "Time", "Iterations", "Items/us");
+    fprintf(out, "-----------------------------------------------------------------------\n");
+
+    for(size_t i = 0; i < (sizeof(benches) / sizeof(benches[0])); i++)
+    {
+        if(strstr(benches[i].name, filter)) bench_run(&benches[i]);
+    }
+
+    fclose(out);
+    return 0;
+}
+
+static uint64_t bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/* like Google Benchmark: the iteration number grows until the run is long enough */
+static void bench_run(const bench_case *bench)
+{
+    uint64_t iter_n = 1;
+    uint64_t elapsed;
+
+    bench->fn();
+
+    while(1)
+    {
+        uint64_t start = bench_now();
+
+        for(uint64_t i = 0; i < iter_n; i++)
+        {
+            bench->fn();
+        }
+
+        elapsed = bench_now() - start;
+
+        if(elapsed >= BENCH_MIN_NS) break;
+
+        iter_n *= (elapsed < (BENCH_MIN_NS / 10)) ? 10 : 2;
+    }
+
+    fprintf(out, "%-32s %11.0f ns %12llu", bench->name, (double)elapsed / iter_n, (unsigned long long)iter_n);
+
+    if(bench->item_n) fprintf(out, " %10.2f", (double)(bench->item_n * iter_n * 1000) / elapsed);
+
+    fprintf(out, "\n");
+    fflush(out);
+}
+
+static void bench_color_hsl_to_rgb()
+{
+    static color_hsl hsl = {.hue = 0, .sat = 1.0f, .lum = 0.5f};
+    color_rgb rgb = color_hsl_to_rgb(hsl);
+    sink += rgb.r + rgb.g + rgb.b;
+    hsl.hue += 7.0f;
+
+    if(hsl.hue >= 360.0f) hsl.hue -= 360.0f;
+}
+
+static void bench_color_hsl_to_rgb_px()
+{
+    for(size_t i = 0; i < BENCH_PIXEL_N; i++)
+    {
+        px_rgb[i] = color_hsl_to_rgb(px_hsl[i]);
+    }
+
+    sink += px_rgb[BENCH_PIXEL_N - 1].r;
+}
+
+static void bench_color_hsl_fix_to_rgb_n()
+{
+    color_hsl_fix_to_rgb_n(px_hsl_fix, px_rgb, BENCH_PIXEL_N);
+    sink += px_rgb[BENCH_PIXEL_N - 1].r;
+}
+
+static void bench_dsp_new_data()
+{
+    dsp_new_data(packet, sizeof(packet));
+}
+
+static void bench_dsp_fft()
+{
+    /* one DSP loop of tasks_dsp */
+    dsp_work_buf_init();
+    dsp_fft_do();
+    dsp_fft_finalize();
+}
+
+static void bench_lights_main_fft()
+{
+    lights_zones[0].first->shader.need_render = true;
+    sink += lights_main();
+}
+
+static void bench_lights_main_fft_apa102()
+{
+    lights_zones[1].first->shader.need_render = true;
+    sink += lights_main();
+}
+
+static void bench_mled_i2s_encode()
+{
+    mled_i2s_encode(i2s_strips, MLED_I2S_LANE_N, i2s_buf, BENCH_PIXEL_N * 3);
+    sink += i2s_buf[1];
+}
+
+static void bench_web_ws_handshake()
+{
+    /* strip, zone, shader and audio profile config to a new client */
+    httpd_req_t req = {
+        .method = HTTP_GET,
+        .sockfd = 1
+    };
+    web_ws(&req);
+}
+
+static void bench_web_ws_audio_meter()
+{
+    static const uint8_t msg[] = {WEB_WS_SID_AUDIO_METER_GET};
+    /* only the handshake comes with GET */
+    httpd_req_t req = {
+        .method = HTTP_POST,
+        .sockfd = 1,
+        .ws_payload = msg,
+        .ws_len = sizeof(msg)
+    };
+    web_ws(&req);
+}
@@ -0,0 +1,39 @@
+/*
+ * Peripheral mocks of the host build (audio codec, LED strips)
+ */
+
+#ifndef __MOCK_H__
+#define __MOCK_H__
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/* a jump this large between two samples is a click (music at 44.1kHz rarely has it) */
+#define MOCK_CLICK_STEP 4096
+
+
+typedef struct {
+    uint64_t written_bytes; // by ach_player_data
+    uint32_t write_timeout; // writes not fit into the DMA buffers in 30ms (cut)
+    uint32_t dma_full; // DMA buffers played out with audio data
+    uint32_t dma_partial; // DMA buffers ran empty while playing (underrun)
+    uint32_t dma_empty; // DMA buffers played out silence after the first data (underrun)
+    uint32_t played_hash; // FNV-1a of the played out PCM, compares replays
+    uint32_t step_max; // largest sample to sample step of a channel, with the silence of the underruns
+    uint32_t click_n; // steps over MOCK_CLICK_STEP, the audible discontinuities
+} mock_i2s_stat;
+
+typedef struct {
+    uint32_t frame_n; // mled_update count
+    int64_t last_us; // time of the last mled_update
+    uint32_t frame_hash; // FNV-1a of the last sent frame
+} mock_mled_stat;
+
+
+void mock_i2s_stat_get(mock_i2s_stat *stat);
+void mock_mled_stat_get(size_t strip_index, mock_mled_stat *stat);
+
+
+#endif /* __MOCK_H__ */
@@ -0,0 +1,193 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "app_config.h"
+#include "app_tools.h"
+#include "ach.h"
+#include "mock.h"
+
+
+/* I2S DMA model: the DMA plays out one dma_buf_frames buffer
+ * in every buffer time from the written data, then signals on_sent,
+ * the written data waits in the other dma_buf_n - 1 buffers */
+#define MOCK_FRAME_SIZE (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N)
+#define MOCK_WRITE_TIMEOUT_TICKS pdMS_TO_TICKS(30)
+#define MOCK_FNV_PRIME 16777619UL
+#define MOCK_FNV_BASIS 2166136261UL
+
+
+static void mock_ach_dma_callback(void *arg);
+static void mock_ach_steps(const int16_t *samples, size_t sample_n);
+
+
+static const char *TAG = LOG_COLOR("95") "CODEC" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("95") "CODEC" LOG_COLOR_E;
+static esp_timer_handle_t dma_timer = NULL;
+static TaskHandle_t notify_task = NULL;
+static uint8_t *queued = NULL; // written data waiting for the DMA
+static size_t queued_len = 0;
+static size_t queued_max = 0;
+static size_t dma_buf_size = 0;
+static uint32_t dma_buf_frames = 0;
+static int64_t dma_start_time = 0;
+static uint64_t dma_buf_cnt = 0;
+static bool started = false;
+static bool data_seen = false;
+static mock_i2s_stat stat = {.played_hash = MOCK_FNV_BASIS};
+/* last played sample of the channels */
+static int16_t last_sample[AUDIO_CHANNEL_N] = {0};
+static const int16_t silence[AUDIO_CHANNEL_N] = {0};
+
+
+void ach_control_init()
+{
+    ESP_LOGI(TAG, "mock codec control init OK");
+}
+
+void ach_volume(uint8_t vol)
+{
+}
+
+void ach_unmute()
+{
+}
+
+void ach_mute()
+{
+}
+
+bool ach_player_init(uint8_t dma_buf_n, uint32_t dma_buf_frames_n, TaskHandle_t sent_notify)
+{
+    esp_timer_create_args_t timer_args = {
+        .callback = mock_ach_dma_callback,
+        .dispatch_method = ESP_TIMER_ISR,
+        .name = "mock_dma"
+    };
+    ERR_CHECK_RETURN_VAL(esp_timer_create(&timer_args, &dma_timer), false);
+    dma_buf_frames = dma_buf_frames_n;
+    dma_buf_size = dma_buf_frames * MOCK_FRAME_SIZE;
+    queued_max = (dma_buf_n - 1) * dma_buf_size;
+    queued = malloc(queued_max);
+    ERR_IF_NULL_RETURN_VAL(queued, false);
+    queued_len = 0;
+    notify_task = sent_notify;
+    ESP_LOGI(TAG, "mock I2S channel init OK with buf size: %d", dma_buf_n * dma_buf_size);
+    return true;
+}
+
+void ach_player_deinit()
+{
+    if(!dma_timer) return;
+
+    esp_timer_stop(dma_timer);
+    esp_timer_delete(dma_timer);
+    dma_timer = NULL;
+    free(queued);
+    queued = NULL;
+}
+
+void ach_player_data(const void *src, size_t size)
+{
+    /* like i2s_channel_write: waits for free DMA buffers up to the timeout */
+    TickType_t start = xTaskGetTickCount();
+
+    while((queued_len + size) > queued_max)
+    {
+        if((xTaskGetTickCount() - start) >= MOCK_WRITE_TIMEOUT_TICKS)
+        {
+            ESP_LOGE(TAGE, "I2S channel write: ESP_ERR_TIMEOUT, %d/%d", queued_max - queued_len, size);
+            stat.write_timeout++;
+            size = queued_max - queued_len;
+            break;
+        }
+
+        vTaskDelay(1);
+    }
+
+    memcpy(&queued[queued_len], src, size);
+    queued_len += size;
+    stat.written_bytes += size;
+
+    if(size) data_seen = true;
+}
+
+void ach_player_refilled(bool measure)
+{
+}
+
+void ach_player_refill_stat(ach_refill_stat *stat, bool reset)
+{
+    /* the DMA model has no refill deadline */
+    *stat = (ach_refill_stat) {.slack_min = INT32_MAX};
+}
+
+void ach_player_start()
+{
+    ESP_LOGW(TAG, "I2S channel STARTED");
+    started = true;
+    data_seen = false;
+    dma_buf_cnt = 0;
+    dma_start_time = esp_timer_get_time();
+    ERR_CHECK(esp_timer_start_once(dma_timer, ((uint64_t)dma_buf_frames * 1000000) / AUDIO_SAMPLE_RATE));
+}
+
+void ach_player_stop()
+{
+    ESP_LOGW(TAG, "I2S channel STOPPED");
+    started = false;
+    esp_timer_stop(dma_timer);
+    queued_len = 0;
+}
+
+void mock_i2s_stat_get(mock_i2s_stat *dest)
+{
+    *dest = stat;
+}
+
+static void mock_ach_dma_callback(void *arg)
+{
+    /* one buffer played out, exact AUDIO_SAMPLE_RATE timing without accumulated rounding */
+    size_t len = (queued_len < dma_buf_size) ? queued_len : dma_buf_size;
+
+    for(size_t i = 0; i < len; i++)
+    {
+        stat.played_hash = (stat.played_hash ^ queued[i]) * MOCK_FNV_PRIME;
+    }
+
+    mock_ach_steps((const int16_t*)queued, len / AUDIO_SAMPLE_BYTE_LEN);
+
+    /* the rest of the buffer auto cleared by the driver */
+    if(data_seen && (len < dma_buf_size)) mock_ach_steps(silence, AUDIO_CHANNEL_N);
+
+    memmove(queued, &queued[len], queued_len - len);
+    queued_len -= len;
+
+    if(len == dma_buf_size) stat.dma_full++;
+    else if(len) stat.dma_partial++;
+    else if(data_seen) stat.dma_empty++;
+
+    BaseType_t need_yield;
+    vTaskNotifyGiveFromISR(notify_task, &need_yield);
+    dma_buf_cnt++;
+    int64_t next = dma_start_time + (int64_t)(((dma_buf_cnt + 1) * dma_buf_frames * 1000000) / AUDIO_SAMPLE_RATE);
+    esp_timer_start_once(dma_timer, next - esp_timer_get_time());
+}
+
+static void mock_ach_steps(const int16_t *samples, size_t sample_n)
+{
+    uint32_t step;
+
+    for(size_t i = 0; i < sample_n; i++)
+    {
+        step = abs(samples[i] - last_sample[i % AUDIO_CHANNEL_N]);
+        last_sample[i % AUDIO_CHANNEL_N] = samples[i];
+
+        if(step > stat.step_max) stat.step_max = step;
+        if(step >= MOCK_CLICK_STEP) stat.click_n++;
+    }
+}
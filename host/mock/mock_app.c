@@ -0,0 +1,7 @@
+
+#include "app_tools.h"
+
+
+void list_tasks_stack_info()
+{
+}
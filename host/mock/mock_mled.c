@@ -0,0 +1,126 @@
+
+#include <stdlib.h>
+
+#include "esp_timer.h"
+
+#include "app_tools.h"
+#include "led_matrix.h"
+#include "trace.h"
+#include "latency.h"
+#include "mock.h"
+
+
+/* RMT transmit model: WS281x bit time (T0H + T0L of ws281x.c)
+ * and the reset code after the pixel data */
+#define MOCK_BIT_NS 940
+#define MOCK_RESET_US 300
+/* SPI transmit model of the clocked strips: the frame with the start and end frames */
+#define MOCK_APA102_US(pixel_n) ((((MLED_APA102_HEAD_SIZE + ((pixel_n) * MLED_APA102_PIXEL_SIZE) + \
+    MLED_APA102_TAIL_SIZE(pixel_n)) * 8LL) * 1000000) / MLED_APA102_CLOCK_HZ)
+#define MOCK_FNV_PRIME 16777619UL
+#define MOCK_FNV_BASIS 2166136261UL
+
+
+static void mock_mled_tx_callback(void *arg);
+
+
+static const char *TAG = LOG_COLOR("96") "MLED" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("96") "MLED" LOG_COLOR_E;
+mled_strip mled_channels[MLED_STRIP_N] = {0};
+static mock_mled_stat stats[MLED_STRIP_N] = {0};
+/* transmit done after the wire time of the frame */
+static esp_timer_handle_t tx_timers[MLED_STRIP_N] = {0};
+
+
+void mled_init()
+{
+    ESP_LOGI(TAG, "mock init OK");
+}
+
+void mled_set_size(mled_strip *strip, size_t pixel_n)
+{
+    /* only the pixels, the start and end frames of the clocked strips are in the wire time */
+    size_t mem_size = pixel_n * ((MLED_TYPE_APA102 == strip->type) ? MLED_APA102_PIXEL_SIZE : MLED_PIXEL_SIZE(strip->rgb_order));
+    mled_pixels *pixels = &strip->pixels;
+
+    if(pixels->data)
+    {
+        ESP_LOGW(TAG, "strip already has pixels buf, freeing %d...", pixels->pixel_n);
+        free(pixels->data);
+        free(pixels->sent);
+        pixels->data = NULL;
+        pixels->sent = NULL;
+        pixels->pixel_n = 0;
+        pixels->data_size = 0;
+    }
+
+    pixels->data = (uint8_t*)calloc(1, mem_size);
+    ERR_IF_NULL_RETURN(pixels->data);
+    pixels->sent = (uint8_t*)calloc(1, mem_size);
+    ERR_IF_NULL_RETURN(pixels->sent);
+    pixels->data_size = mem_size;
+    pixels->frame_size = mem_size;
+    pixels->pixel_n = pixel_n;
+}
+
+bool mled_update(mled_strip *strip)
+{
+    size_t index = strip - mled_channels;
+    ERR_CHECK_RETURN_VAL(MLED_STRIP_N <= index, false);
+    mled_pixels *pixels = &strip->pixels;
+
+    /* the harnesses set the strips up without mled_init */
+    if(!tx_timers[index])
+    {
+        esp_timer_create_args_t timer_args = {
+            .callback = mock_mled_tx_callback,
+            .arg = (void*)index,
+            .dispatch_method = ESP_TIMER_ISR,
+            .name = "mock_rmt"
+        };
+        ERR_CHECK_RETURN_VAL(esp_timer_create(&timer_args, &tx_timers[index]), false);
+    }
+
+    if(strip->tx_busy) return false;
+
+    /* the frame is hashed at the transmit start */
+    mock_mled_stat *stat = &stats[index];
+    stat->frame_n++;
+    stat->last_us = esp_timer_get_time();
+    stat->frame_hash = MOCK_FNV_BASIS;
+
+    for(size_t i = 0; i < pixels->data_size; i++)
+    {
+        stat->frame_hash = (stat->frame_hash ^ pixels->data[i]) * MOCK_FNV_PRIME;
+    }
+
+    strip->tx_busy = true;
+    int64_t wire_us = ((int64_t)pixels->data_size * 8 * MOCK_BIT_NS) / 1000 + MOCK_RESET_US;
+
+    if(MLED_TYPE_APA102 == strip->type) wire_us = MOCK_APA102_US(pixels->pixel_n);
+
+    ERR_CHECK(esp_timer_start_once(tx_timers[index], wire_us));
+    uint8_t *front = pixels->sent;
+    pixels->sent = pixels->data;
+    pixels->data = front;
+    return true;
+}
+
+bool mled_flush()
+{
+    /* RMT model, the strips already sent by mled_update */
+    return true;
+}
+
+void mock_mled_stat_get(size_t strip_index, mock_mled_stat *stat)
+{
+    *stat = stats[strip_index];
+}
+
+static void mock_mled_tx_callback(void *arg)
+{
+    size_t index = (size_t)arg;
+    mled_channels[index].tx_busy = false;
+    trace_event(TRACE_RMT_DONE, index);
+    latency_reached(LATENCY_STAGE_TX);
+}
@@ -0,0 +1,13 @@
+
+#include "app_tools.h"
+#include "storage.h"
+
+
+/* built without cJSON: no config parsing, the configs are not saved */
+void storage_save_lights()
+{
+}
+
+void storage_save_audio_profile(audio_profile_id id)
+{
+}
@@ -0,0 +1,390 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "sim.h"
+#include "mock.h"
+#include "app_config.h"
+#include "app_tools.h"
+#include "tasks.h"
+#include "lights.h"
+#include "audio_profile.h"
+#include "capture.h"
+#include "trace.h"
+#include "instr.h"
+#include "latency.h"
+
+
+/* priority of the Bluedroid BTC task, which calls tasks_audio_data on the device */
+#define REPLAY_PRIO 19
+/* the trace ring is collected at least this often, it must not wrap around meanwhile */
+#define REPLAY_COLLECT_US 500000
+#define REPLAY_FLUSH_TIMEOUT_US 5000000
+#define REPLAY_PIXEL_N 60
+#define REPLAY_TONE_HZ 440.0f
+#define REPLAY_TONE_AMPLITUDE 8000.0f
+/* -i: a click this long at the start of a packet, silence elsewhere */
+#define REPLAY_CLICK_FRAMES 64
+#define REPLAY_CLICK_AMPLITUDE INT16_MAX
+#define REPLAY_AUDIO_STATE_STOP 1 // audio_state_t of tasks.c
+#define REPLAY_AUDIO_STATE_DROP 5
+/* -j: the same pseudo random arrival jitter on every run */
+#define REPLAY_JITTER_SEED 1
+
+
+typedef struct {
+    uint32_t drop_n; // entering DROP state
+    uint32_t trim_n; // overflow concealed by trimming a packet
+    uint32_t fill_n; // underrun concealed by fade out
+    uint32_t ring_fill_max; // audio ringbuf waiting bytes
+    uint32_t dsp_n;
+    uint32_t lights_n;
+    uint32_t rmt_n;
+    bool stopped; // audio state STOP after the stream
+} replay_stat;
+
+
+static void replay_wait_until(int64_t time_us);
+static void replay_wait_callback(void *arg);
+static void replay_trace_collect();
+static void replay_tone(uint8_t *pcm, size_t len);
+static void replay_click(uint8_t *pcm, size_t len, uint32_t time_us, uint32_t period_us);
+static void replay_lights_init(size_t pixel_n);
+static void replay_report(uint32_t packet_n, uint64_t packet_bytes, int64_t duration_us);
+
+
+static const char *TAG = LOG_COLOR("92") "REPLAY" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("92") "REPLAY" LOG_COLOR_E;
+static replay_stat stat = {0};
+static esp_timer_handle_t wait_timer = NULL;
+/* trace records before this time already collected */
+static int64_t collected_until = 0;
+static float tone_phase = 0;
+static color_hsl fft_colors[] = {
+    {.hue = 0, .sat = 1.0f, .lum = 0.5f},
+    {.hue = 240, .sat = 1.0f, .lum = 0.5f}
+};
+
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    audio_profile_id profile_id = AUDIO_PROFILE_MAX;
+    size_t pixel_n = REPLAY_PIXEL_N;
+    uint32_t click_period_ms = 0;
+    uint32_t jitter_ms = 0;
+    bool verbose = false;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "-v")) verbose = true;
+        else if(!strcmp(argv[i], "-p") && ((i + 1) < argc)) profile_id = audio_profile_find(argv[++i]);
+        else if(!strcmp(argv[i], "-n") && ((i + 1) < argc)) pixel_n = strtoul(argv[++i], NULL, 0);
+        else if(!strcmp(argv[i], "-i") && ((i + 1) < argc)) click_period_ms = strtoul(argv[++i], NULL, 0);
+        else if(!strcmp(argv[i], "-j") && ((i + 1) < argc)) jitter_ms = strtoul(argv[++i], NULL, 0);
+        else path = argv[i];
+    }
+
+    if(!path || !pixel_n)
+    {
+        fprintf(stderr, "usage: %s [-v] [-p low_latency|balanced|robust] [-n pixel_n] [-i click_period_ms] [-j jitter_ms] capture.bin\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = fopen(path, "rb");
+
+    if(!file)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *capture = malloc(file_len);
+
+    if(!capture || (file_len < 8) || (fread(capture, 1, file_len, file) != (size_t)file_len))
+    {
+        fprintf(stderr, "%s: can't read\n", path);
+        return 1;
+    }
+
+    fclose(file);
+    uint32_t magic, record_n;
+    memcpy(&magic, capture, 4);
+    memcpy(&record_n, &capture[4], 4);
+
+    if(magic != CAPTURE_MAGIC)
+    {
+        fprintf(stderr, "%s: not a capture\n", path);
+        return 1;
+    }
+
+    sim_start("BTC", REPLAY_PRIO);
+    esp_log_level_set("*", verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+    ESP_LOGI(TAG, "%ld packets from %s", record_n, path);
+    replay_lights_init(pixel_n);
+    tasks_create();
+
+    if(profile_id < AUDIO_PROFILE_MAX) tasks_audio_profile_select(profile_id, false);
+
+    /* the tasks initialize the peripherals */
+    vTaskDelay(pdMS_TO_TICKS(100));
+    /* the statistic counts from the stream start */
+    replay_trace_collect();
+    stat = (replay_stat) {0};
+    tasks_signal signal = {
+        .aim_task = TASKS_INST_AUDIO_PLAYER,
+        .type = TASKS_SIG_AUDIO_STREAM_STARTED
+    };
+    tasks_message(signal);
+
+    size_t pos = 8;
+    uint8_t *pcm = NULL;
+    uint32_t packet_n = 0;
+    uint64_t packet_bytes = 0;
+    /* the first packet comes a tick after the stream start event */
+    int64_t start_time = esp_timer_get_time() + (1000000 / configTICK_RATE_HZ);
+    uint32_t first_time = 0;
+    capture_record record;
+    int64_t arrival;
+    srand(REPLAY_JITTER_SEED);
+
+    for(; packet_n < record_n; packet_n++)
+    {
+        if((pos + sizeof(capture_record)) > (size_t)file_len) break;
+
+        memcpy(&record, &capture[pos], sizeof(capture_record));
+        pos += sizeof(capture_record);
+
+        if((pos + record.stored_len) > (size_t)file_len) break;
+        if(!packet_n) first_time = record.time_us;
+
+        arrival = start_time + (record.time_us - first_time);
+
+        /* each packet late by [0..jitter_ms], still in order (a less late one waits for the previous) */
+        if(jitter_ms) arrival += ((int64_t)rand() * jitter_ms * 1000) / RAND_MAX;
+
+        replay_wait_until(arrival);
+
+        if(click_period_ms)
+        {
+            /* only the packet timing kept, the audio replaced by clicks */
+            pcm = realloc(pcm, record.len);
+            ERR_IF_NULL_RESET(pcm);
+            replay_click(pcm, record.len, record.time_us - first_time, click_period_ms * 1000);
+            tasks_audio_data(pcm, record.len);
+        }
+        else if(record.stored_len)
+        {
+            tasks_audio_data(&capture[pos], record.stored_len);
+        }
+        else
+        {
+            /* only the timing captured after the buffer filled up */
+            pcm = realloc(pcm, record.len);
+            ERR_IF_NULL_RESET(pcm);
+            replay_tone(pcm, record.len);
+            tasks_audio_data(pcm, record.len);
+        }
+
+        pos += record.stored_len;
+        packet_bytes += record.len;
+    }
+
+    if(packet_n < record_n) ESP_LOGE(TAGE, "capture truncated at packet %ld", packet_n);
+
+    int64_t duration = esp_timer_get_time() - start_time;
+    signal.type = TASKS_SIG_AUDIO_STREAM_SUSPEND;
+    tasks_message(signal);
+    int64_t flush_timeout = esp_timer_get_time() + REPLAY_FLUSH_TIMEOUT_US;
+
+    while(!stat.stopped && (esp_timer_get_time() < flush_timeout))
+    {
+        replay_wait_until(esp_timer_get_time() + REPLAY_COLLECT_US);
+    }
+
+    if(!stat.stopped) ESP_LOGE(TAGE, "audio not stopped after the stream");
+
+    replay_report(packet_n, packet_bytes, duration);
+    free(pcm);
+    free(capture);
+    /* the simulated tasks never end */
+    exit(0);
+}
+
+static void replay_wait_until(int64_t time_us)
+{
+    if(!wait_timer)
+    {
+        esp_timer_create_args_t timer_args = {
+            .callback = replay_wait_callback,
+            .arg = xTaskGetCurrentTaskHandle(),
+            .name = "replay"
+        };
+        ERR_CHECK_RESET(esp_timer_create(&timer_args, &wait_timer));
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    while(now < time_us)
+    {
+        int64_t wait_us = time_us - now;
+
+        if(wait_us > REPLAY_COLLECT_US) wait_us = REPLAY_COLLECT_US;
+
+        /* vTaskDelay has tick resolution, the rest spent in a one-shot timer */
+        TickType_t ticks = wait_us / (1000000 / configTICK_RATE_HZ);
+
+        if(ticks) vTaskDelay(ticks);
+        else
+        {
+            ERR_CHECK_RESET(esp_timer_start_once(wait_timer, wait_us));
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        now = esp_timer_get_time();
+        replay_trace_collect();
+    }
+}
+
+static void replay_wait_callback(void *arg)
+{
+    vTaskNotifyGiveFromISR((TaskHandle_t)arg, NULL);
+}
+
+/* records of [collected_until..now) are complete, this task has the highest priority,
+ * so the others have not run yet at this time */
+static void replay_trace_collect()
+{
+    int64_t now = esp_timer_get_time();
+    size_t len;
+    uint8_t *snapshot = trace_snapshot(&len);
+    ERR_IF_NULL_RETURN(snapshot);
+    uint32_t record_n;
+    memcpy(&record_n, &snapshot[4], 4);
+    trace_record *records = (trace_record*)&snapshot[8];
+
+    for(uint32_t i = 0; i < record_n; i++)
+    {
+        trace_record *record = &records[i];
+
+        if((record->time_us < (uint32_t)collected_until) || (record->time_us >= (uint32_t)now)) continue;
+
+        switch(record->event)
+        {
+            case TRACE_AUDIO_STATE:
+                if(record->arg == REPLAY_AUDIO_STATE_DROP) stat.drop_n++;
+                else if(record->arg == REPLAY_AUDIO_STATE_STOP) stat.stopped = true;
+
+                break;
+            case TRACE_RING_FILL:
+                if(record->arg > stat.ring_fill_max) stat.ring_fill_max = record->arg;
+
+                break;
+            case TRACE_CONCEAL:
+                if(record->arg) stat.fill_n++;
+                else stat.trim_n++;
+
+                break;
+            case TRACE_DSP_END: stat.dsp_n++; break;
+            case TRACE_LIGHTS_END: stat.lights_n++; break;
+            case TRACE_RMT_DONE: stat.rmt_n++; break;
+            default: break;
+        }
+    }
+
+    collected_until = now;
+    free(snapshot);
+}
+
+/* stereo sine instead of the not captured PCM */
+static void replay_tone(uint8_t *pcm, size_t len)
+{
+    int16_t *frame = (int16_t*)pcm;
+    float step = 2.0f * (float)M_PI * REPLAY_TONE_HZ / (float)AUDIO_SAMPLE_RATE;
+
+    for(size_t i = 0; i < (len / (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N)); i++)
+    {
+        frame[0] = frame[1] = REPLAY_TONE_AMPLITUDE * sinf(tone_phase);
+        frame += AUDIO_CHANNEL_N;
+        tone_phase += step;
+
+        if(tone_phase > (2.0f * (float)M_PI)) tone_phase -= 2.0f * (float)M_PI;
+    }
+}
+
+/* silent packet, but a click in the first packet of every period */
+static void replay_click(uint8_t *pcm, size_t len, uint32_t time_us, uint32_t period_us)
+{
+    static uint32_t next_click_us = 0;
+    memset(pcm, 0, len);
+
+    if(time_us < next_click_us) return;
+
+    int16_t *frame = (int16_t*)pcm;
+
+    for(size_t i = 0; (i < REPLAY_CLICK_FRAMES) && (i < (len / (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N))); i++)
+    {
+        frame[0] = frame[1] = REPLAY_CLICK_AMPLITUDE;
+        frame += AUDIO_CHANNEL_N;
+    }
+
+    next_click_us = time_us + period_us;
+}
+
+/* one FFT zone on the whole first strip, like a config.json would set */
+static void replay_lights_init(size_t pixel_n)
+{
+    mled_channels[0].rgb_order = (mled_rgb_order) {.i_r = 1, .i_g = 0, .i_b = 2};
+    lights_set_strip_size(0, pixel_n);
+    lights_zone_chain *zone = lights_new_zone(0, pixel_n);
+    ERR_IF_NULL_RESET(zone);
+    lights_shader *shader = &zone->shader;
+    shader->type = SHADER_FFT;
+    shader->cfg.shader_fft = (lights_shader_cfg_fft) {
+        .colors = fft_colors,
+        .color_n = sizeof(fft_colors) / sizeof(fft_colors[0]),
+        .is_right = false,
+        .intensity = 1.0f,
+        .mirror = false
+    };
+    lights_shader_init_fft(zone);
+    shader->need_render = true;
+}
+
+static void replay_report(uint32_t packet_n, uint64_t packet_bytes, int64_t duration_us)
+{
+    mock_i2s_stat i2s;
+    mock_mled_stat mled;
+    lights_tx_stat tx_stat;
+    static char instr_text[INSTR_DUMP_SIZE];
+    static char latency_text[LATENCY_DUMP_SIZE];
+    mock_i2s_stat_get(&i2s);
+    mock_mled_stat_get(0, &mled);
+    lights_get_tx_stat(0, &tx_stat, false);
+    instr_dump(instr_text, sizeof(instr_text), false);
+    latency_dump(latency_text, sizeof(latency_text), false);
+
+    printf("packets: %lu, %llu bytes in %.3fs\n", (unsigned long)packet_n, (unsigned long long)packet_bytes, duration_us / 1e6);
+    printf("audio: drops: %lu, trims: %lu, underrun fills: %lu, ringbuf max: %lu bytes\n",
+        (unsigned long)stat.drop_n, (unsigned long)stat.trim_n, (unsigned long)stat.fill_n, (unsigned long)stat.ring_fill_max);
+    printf("I2S DMA buffers: full: %lu, partial: %lu, empty: %lu, write timeouts: %lu, written: %llu bytes\n",
+        (unsigned long)i2s.dma_full, (unsigned long)i2s.dma_partial, (unsigned long)i2s.dma_empty,
+        (unsigned long)i2s.write_timeout, (unsigned long long)i2s.written_bytes);
+    printf("loops: DSP: %lu, lights: %lu, strip frames: %lu, unchanged skipped: %lu\n",
+        (unsigned long)stat.dsp_n, (unsigned long)stat.lights_n, (unsigned long)mled.frame_n, (unsigned long)tx_stat.skipped);
+    /* same input has to give the same hashes on every run */
+    printf("discontinuities: max step: %lu, clicks (step >= %d): %lu\n", (unsigned long)i2s.step_max, MOCK_CLICK_STEP, (unsigned long)i2s.click_n);
+    printf("played audio hash: %08lx, last frame hash: %08lx\n", (unsigned long)i2s.played_hash, (unsigned long)mled.frame_hash);
+    printf("host frame times [ns]:\n%s", instr_text);
+    /* simulated time, the DSP and lights code takes none of it */
+    printf("%s", latency_text);
+}
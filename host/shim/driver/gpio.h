@@ -0,0 +1,15 @@
+/*
+ * ESP-IDF GPIO types of the host build,
+ * led_matrix.h declares the strip init with them, the strips are mocked
+ */
+
+#ifndef __SHIM_GPIO_H__
+#define __SHIM_GPIO_H__
+
+
+typedef enum {
+    GPIO_NUM_NC = -1
+} gpio_num_t;
+
+
+#endif /* __SHIM_GPIO_H__ */
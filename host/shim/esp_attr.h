@@ -0,0 +1,14 @@
+/*
+ * ESP-IDF memory placement attributes of the host build (no effect)
+ */
+
+#ifndef __SHIM_ESP_ATTR_H__
+#define __SHIM_ESP_ATTR_H__
+
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+
+
+#endif /* __SHIM_ESP_ATTR_H__ */
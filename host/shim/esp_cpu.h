@@ -0,0 +1,27 @@
+/*
+ * ESP-IDF CPU API of the host build,
+ * cycle count of a CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ clock from the host clock
+ */
+
+#ifndef __SHIM_ESP_CPU_H__
+#define __SHIM_ESP_CPU_H__
+
+
+#include <stdint.h>
+#include <time.h>
+
+#include "sdkconfig.h"
+
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+
+static inline esp_cpu_cycle_count_t esp_cpu_get_cycle_count()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec) * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 1000);
+}
+
+
+#endif /* __SHIM_ESP_CPU_H__ */
@@ -0,0 +1,16 @@
+/*
+ * ESP-IDF debug helpers of the host build
+ */
+
+#ifndef __SHIM_ESP_DEBUG_HELPERS_H__
+#define __SHIM_ESP_DEBUG_HELPERS_H__
+
+
+#include "esp_err.h"
+
+
+/* prints only the simulated task name, no backtrace on host */
+esp_err_t esp_backtrace_print(int depth);
+
+
+#endif /* __SHIM_ESP_DEBUG_HELPERS_H__ */
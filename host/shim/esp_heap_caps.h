@@ -0,0 +1,25 @@
+/*
+ * ESP-IDF capability based heap API of the host build (plain malloc)
+ */
+
+#ifndef __SHIM_ESP_HEAP_CAPS_H__
+#define __SHIM_ESP_HEAP_CAPS_H__
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+#define MALLOC_CAP_DEFAULT (1 << 12)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DMA (1 << 3)
+
+
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_calloc(n, size, caps) calloc(n, size)
+#define heap_caps_free(ptr) free(ptr)
+
+
+#endif /* __SHIM_ESP_HEAP_CAPS_H__ */
@@ -0,0 +1,112 @@
+/*
+ * ESP-IDF HTTP server API of the host build (httpd.c),
+ * only the websocket part: requests are built by the caller,
+ * sent frames are counted, the first ones kept for the tests
+ */
+
+#ifndef __SHIM_ESP_HTTP_SERVER_H__
+#define __SHIM_ESP_HTTP_SERVER_H__
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+
+#define HTTPD_MAX_URI_LEN 512
+/* sent frames kept since the last httpd_shim_stat_take, their first bytes */
+#define HTTPD_SHIM_FRAME_N 8
+#define HTTPD_SHIM_FRAME_SIZE 256
+
+
+typedef void *httpd_handle_t;
+
+/* values of http_parser.h */
+typedef enum {
+    HTTP_DELETE,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT
+} httpd_method_t;
+
+typedef enum {
+    HTTPD_500_INTERNAL_SERVER_ERROR,
+    HTTPD_501_METHOD_NOT_IMPLEMENTED,
+    HTTPD_505_VERSION_NOT_SUPPORTED,
+    HTTPD_400_BAD_REQUEST,
+    HTTPD_401_UNAUTHORIZED,
+    HTTPD_403_FORBIDDEN,
+    HTTPD_404_NOT_FOUND,
+    HTTPD_405_METHOD_NOT_ALLOWED,
+    HTTPD_408_REQ_TIMEOUT,
+    HTTPD_411_LENGTH_REQUIRED,
+    HTTPD_414_URI_TOO_LONG,
+    HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE,
+    HTTPD_ERR_CODE_MAX
+} httpd_err_code_t;
+
+typedef enum {
+    HTTPD_WS_TYPE_CONTINUE = 0x0,
+    HTTPD_WS_TYPE_TEXT = 0x1,
+    HTTPD_WS_TYPE_BINARY = 0x2,
+    HTTPD_WS_TYPE_CLOSE = 0x8,
+    HTTPD_WS_TYPE_PING = 0x9,
+    HTTPD_WS_TYPE_PONG = 0xA
+} httpd_ws_type_t;
+
+typedef enum {
+    HTTPD_WS_CLIENT_INVALID = 0x0,
+    HTTPD_WS_CLIENT_HTTP = 0x1,
+    HTTPD_WS_CLIENT_WEBSOCKET = 0x2
+} httpd_ws_client_info_t;
+
+typedef struct {
+    bool final;
+    bool fragmented;
+    httpd_ws_type_t type;
+    uint8_t *payload;
+    size_t len;
+} httpd_ws_frame_t;
+
+typedef struct httpd_req {
+    httpd_handle_t handle;
+    int method;
+    const char uri[HTTPD_MAX_URI_LEN + 1];
+    size_t content_len;
+    void *user_ctx;
+    /* host only: the client socket and the received websocket frame */
+    int sockfd;
+    const uint8_t *ws_payload;
+    size_t ws_len;
+} httpd_req_t;
+
+typedef void (*transfer_complete_cb)(esp_err_t err, int socket, void *arg);
+
+typedef struct {
+    size_t frame_n;
+    size_t byte_n;
+} httpd_shim_stat;
+
+typedef struct {
+    uint8_t payload[HTTPD_SHIM_FRAME_SIZE];
+    size_t len; // the sent length, only HTTPD_SHIM_FRAME_SIZE bytes of it kept
+} httpd_shim_frame;
+
+
+int httpd_req_to_sockfd(httpd_req_t *req);
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len);
+/* the frame counted and kept if there is place, the callback called right away */
+esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame, transfer_complete_cb callback, void *arg);
+/* one websocket client (socket 1) is connected */
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fd_n, int *fds);
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int sockfd);
+/* sent frames since the last call, the kept frames dropped */
+void httpd_shim_stat_take(httpd_shim_stat *stat);
+/* i. frame sent since the last httpd_shim_stat_take, NULL if not kept */
+const httpd_shim_frame *httpd_shim_frame_get(size_t i);
+
+
+#endif /* __SHIM_ESP_HTTP_SERVER_H__ */
@@ -0,0 +1,55 @@
+/*
+ * ESP-IDF logging API of the host build
+ */
+
+#ifndef __SHIM_ESP_LOG_H__
+#define __SHIM_ESP_LOG_H__
+
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+
+#define LOG_COLOR_BLACK "30"
+#define LOG_COLOR_RED "31"
+#define LOG_COLOR_GREEN "32"
+#define LOG_COLOR_BROWN "33"
+#define LOG_COLOR(COLOR) "\033[0;" COLOR "m"
+#define LOG_BOLD(COLOR) "\033[1;" COLOR "m"
+#define LOG_RESET_COLOR "\033[0m"
+#define LOG_COLOR_E LOG_COLOR(LOG_COLOR_RED)
+#define LOG_COLOR_W LOG_COLOR(LOG_COLOR_BROWN)
+#define LOG_COLOR_I LOG_COLOR(LOG_COLOR_GREEN)
+
+/* timestamps are the simulated time [ms] */
+#define ESP_LOG_LEVEL(level, letter, tag, format, ...) do {                                    \
+        if(esp_log_level_get(tag) >= level) {                                                   \
+            printf("%c (%lu) %s: " format LOG_RESET_COLOR "\n",                                 \
+                letter, (unsigned long)esp_log_timestamp(), tag, ##__VA_ARGS__);                \
+        }                                                                                       \
+    } while(0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_INFO, 'I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_DEBUG, 'D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_VERBOSE, 'V', tag, format, ##__VA_ARGS__)
+
+
+/* only the "*" tag (all tags) supported */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char *tag);
+uint32_t esp_log_timestamp();
+
+
+#endif /* __SHIM_ESP_LOG_H__ */
@@ -0,0 +1,22 @@
+/*
+ * ESP-IDF power management types of the host build,
+ * CONFIG_PM_ENABLE is off, so only the types are used
+ */
+
+#ifndef __SHIM_ESP_PM_H__
+#define __SHIM_ESP_PM_H__
+
+
+#include "esp_err.h"
+
+
+typedef struct esp_pm_lock *esp_pm_lock_handle_t;
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP
+} esp_pm_lock_type_t;
+
+
+#endif /* __SHIM_ESP_PM_H__ */
@@ -0,0 +1,93 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_debug_helpers.h"
+#include "driver/rmt_encoder.h"
+
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    log_level = level;
+}
+
+esp_log_level_t esp_log_level_get(const char *tag)
+{
+    return log_level;
+}
+
+uint32_t esp_log_timestamp()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch(code)
+    {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+esp_err_t esp_backtrace_print(int depth)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    TaskStatus_t status[32];
+    UBaseType_t task_n = uxTaskGetSystemState(status, 32, NULL);
+
+    for(UBaseType_t i = 0; i < task_n; i++)
+    {
+        if(status[i].xHandle == task) fprintf(stderr, "Backtrace: in task %s\n", status[i].pcTaskName);
+    }
+
+    return ESP_OK;
+}
+
+uint32_t esp_get_free_heap_size()
+{
+    return 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size()
+{
+    return 0;
+}
+
+esp_err_t rmt_new_bytes_encoder(const rmt_bytes_encoder_config_t *config, rmt_encoder_t **ret_encoder)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t *config, rmt_encoder_t **ret_encoder)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config, rmt_encoder_t **ret_encoder)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void esp_restart()
+{
+    fprintf(stderr, "esp_restart\n");
+    exit(1);
+}
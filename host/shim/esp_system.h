@@ -0,0 +1,20 @@
+/*
+ * ESP-IDF system API of the host build
+ */
+
+#ifndef __SHIM_ESP_SYSTEM_H__
+#define __SHIM_ESP_SYSTEM_H__
+
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+
+/* heap is not limited on host, always 0 */
+uint32_t esp_get_free_heap_size();
+uint32_t esp_get_minimum_free_heap_size();
+void esp_restart();
+
+
+#endif /* __SHIM_ESP_SYSTEM_H__ */
@@ -0,0 +1,19 @@
+/*
+ * ESP-IDF virtual file system constants of the host build,
+ * the host file system used directly
+ */
+
+#ifndef __SHIM_ESP_VFS_H__
+#define __SHIM_ESP_VFS_H__
+
+
+#include <stdio.h>
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+
+#define ESP_VFS_PATH_MAX 15
+
+
+#endif /* __SHIM_ESP_VFS_H__ */
@@ -0,0 +1,146 @@
+/*
+ * FreeRTOS API of the host simulation (sim.c)
+ *  only the subset used by the application modules
+ */
+
+#ifndef __SHIM_FREERTOS_H__
+#define __SHIM_FREERTOS_H__
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "sdkconfig.h"
+
+
+typedef uint32_t TickType_t;
+/* pointer size like the POSIX port, e.g. the ringbuf info fits into size_t too */
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef struct sim_task *TaskHandle_t;
+typedef struct sim_sem *SemaphoreHandle_t;
+typedef struct sim_queue *QueueHandle_t;
+
+typedef enum {
+    eRunning,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+/* critical sections are not needed, only one simulated task runs at a time */
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define configMAX_PRIORITIES 25
+#define configMAX_TASK_NAME_LEN 16
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks) ((TickType_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+/* both cores are simulated on one, see sim.c */
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7fffffff
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMUX_INITIALIZE(mux) ((void)(mux))
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+#define taskENTER_CRITICAL(mux) ((void)(mux))
+#define taskEXIT_CRITICAL(mux) ((void)(mux))
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+
+/* tasks */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskDelayUntil(TickType_t *prev_wake, TickType_t increment);
+TickType_t xTaskGetTickCount();
+TickType_t xTaskGetTickCountFromISR();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TaskHandle_t xTaskGetIdleTaskHandleForCore(BaseType_t core);
+BaseType_t xTaskGetCoreID(TaskHandle_t task);
+BaseType_t xPortGetCoreID();
+UBaseType_t uxTaskGetNumberOfTasks();
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t status_n, uint32_t *total_run_time);
+uint32_t ulTaskGetRunTimeCounter(TaskHandle_t task);
+void taskYIELD();
+
+/* task notifications */
+BaseType_t xTaskGenericNotify(TaskHandle_t task, UBaseType_t index, uint32_t value, eNotifyAction action, uint32_t *prev_value);
+BaseType_t xTaskGenericNotifyWait(UBaseType_t index, uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks);
+uint32_t ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear_on_exit, TickType_t ticks);
+void vTaskGenericNotifyGiveFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *need_yield);
+
+#define xTaskNotify(task, value, action) xTaskGenericNotify(task, 0, value, action, NULL)
+#define xTaskNotifyIndexed(task, index, value, action) xTaskGenericNotify(task, index, value, action, NULL)
+#define xTaskNotifyFromISR(task, value, action, need_yield) xTaskGenericNotify(task, 0, value, action, NULL)
+#define xTaskNotifyGive(task) xTaskGenericNotify(task, 0, 0, eIncrement, NULL)
+#define xTaskNotifyWait(clear_on_entry, clear_on_exit, value, ticks) xTaskGenericNotifyWait(0, clear_on_entry, clear_on_exit, value, ticks)
+#define xTaskNotifyWaitIndexed(index, clear_on_entry, clear_on_exit, value, ticks) xTaskGenericNotifyWait(index, clear_on_entry, clear_on_exit, value, ticks)
+#define ulTaskNotifyTake(clear_on_exit, ticks) ulTaskGenericNotifyTake(0, clear_on_exit, ticks)
+#define vTaskNotifyGiveFromISR(task, need_yield) vTaskGenericNotifyGiveFromISR(task, 0, need_yield)
+
+/* semaphores (binary, counting and mutex are the same counter) */
+SemaphoreHandle_t sim_sem_create(UBaseType_t max, UBaseType_t initial);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateBinary() sim_sem_create(1, 0)
+#define xSemaphoreCreateMutex() sim_sem_create(1, 1)
+#define xSemaphoreCreateCounting(max, initial) sim_sem_create(max, initial)
+#define xSemaphoreGiveFromISR(sem, need_yield) xSemaphoreGive(sem)
+#define xSemaphoreTakeFromISR(sem, need_yield) xSemaphoreTake(sem, 0)
+
+/* queues */
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#define xQueueSendToBack(queue, item, ticks) xQueueSend(queue, item, ticks)
+
+
+#endif /* __SHIM_FREERTOS_H__ */
@@ -0,0 +1,5 @@
+/*
+ * FreeRTOS queue API of the host simulation, see FreeRTOS.h
+ */
+
+#include "freertos/FreeRTOS.h"
@@ -0,0 +1,32 @@
+/*
+ * ESP-IDF ring buffer API of the host simulation (sim.c)
+ *  only the byte buffer type
+ */
+
+#ifndef __SHIM_RINGBUF_H__
+#define __SHIM_RINGBUF_H__
+
+
+#include "freertos/FreeRTOS.h"
+
+
+typedef struct sim_ringbuf *RingbufHandle_t;
+
+typedef enum {
+    RINGBUF_TYPE_NOSPLIT,
+    RINGBUF_TYPE_ALLOWSPLIT,
+    RINGBUF_TYPE_BYTEBUF,
+    RINGBUF_TYPE_MAX
+} RingbufferType_t;
+
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type);
+void vRingbufferDelete(RingbufHandle_t ringbuf);
+BaseType_t xRingbufferSend(RingbufHandle_t ringbuf, const void *data, size_t size, TickType_t ticks);
+void *xRingbufferReceiveUpTo(RingbufHandle_t ringbuf, size_t *item_size, TickType_t ticks, size_t max_size);
+void vRingbufferReturnItem(RingbufHandle_t ringbuf, void *item);
+/* positions are offsets from the buffer start, like the pointer differences of ringbuf.c */
+void vRingbufferGetInfo(RingbufHandle_t ringbuf, UBaseType_t *free, UBaseType_t *read, UBaseType_t *write, UBaseType_t *acquire, UBaseType_t *items_waiting);
+
+
+#endif /* __SHIM_RINGBUF_H__ */
@@ -0,0 +1,5 @@
+/*
+ * FreeRTOS task API of the host simulation, see FreeRTOS.h
+ */
+
+#include "freertos/FreeRTOS.h"
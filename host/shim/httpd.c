@@ -0,0 +1,83 @@
+
+#include <string.h>
+
+#include "esp_http_server.h"
+
+
+#define HTTPD_SHIM_SOCKFD 1
+
+
+/* web_core.c not built on host */
+httpd_handle_t web_server_hd = (httpd_handle_t)1;
+static httpd_shim_stat stat = {0};
+static httpd_shim_frame frames[HTTPD_SHIM_FRAME_N];
+
+
+int httpd_req_to_sockfd(httpd_req_t *req)
+{
+    return req->sockfd;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+{
+    frame->final = true;
+    frame->fragmented = false;
+    frame->type = HTTPD_WS_TYPE_BINARY;
+
+    /* max_len 0: only the length */
+    if(!max_len)
+    {
+        frame->len = req->ws_len;
+        return ESP_OK;
+    }
+
+    if(!frame->payload) return ESP_ERR_INVALID_ARG;
+
+    frame->len = (req->ws_len < max_len) ? req->ws_len : max_len;
+    memcpy(frame->payload, req->ws_payload, frame->len);
+    return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame, transfer_complete_cb callback, void *arg)
+{
+    if(stat.frame_n < HTTPD_SHIM_FRAME_N)
+    {
+        httpd_shim_frame *kept = &frames[stat.frame_n];
+        kept->len = frame->len;
+        memcpy(kept->payload, frame->payload, (frame->len < HTTPD_SHIM_FRAME_SIZE) ? frame->len : HTTPD_SHIM_FRAME_SIZE);
+    }
+
+    stat.frame_n++;
+    stat.byte_n += frame->len;
+
+    if(callback) callback(ESP_OK, socket, arg);
+
+    return ESP_OK;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fd_n, int *fds)
+{
+    if(!*fd_n) return ESP_ERR_INVALID_ARG;
+
+    fds[0] = HTTPD_SHIM_SOCKFD;
+    *fd_n = 1;
+    return ESP_OK;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int sockfd)
+{
+    return (sockfd == HTTPD_SHIM_SOCKFD) ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_INVALID;
+}
+
+void httpd_shim_stat_take(httpd_shim_stat *dest)
+{
+    *dest = stat;
+    stat = (httpd_shim_stat) {0};
+}
+
+const httpd_shim_frame *httpd_shim_frame_get(size_t i)
+{
+    if((i >= stat.frame_n) || (i >= HTTPD_SHIM_FRAME_N)) return NULL;
+
+    return &frames[i];
+}
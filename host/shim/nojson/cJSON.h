@@ -0,0 +1,13 @@
+/*
+ * cJSON type of the host build without cJSON,
+ * storage.h only declares with it (storage.c replaced by mock_storage.c)
+ */
+
+#ifndef __SHIM_CJSON_H__
+#define __SHIM_CJSON_H__
+
+
+typedef struct cJSON cJSON;
+
+
+#endif /* __SHIM_CJSON_H__ */
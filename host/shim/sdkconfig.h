@@ -0,0 +1,18 @@
+/*
+ * Configuration of the host build
+ *  the audio pipeline runs on the simulated FreeRTOS of sim.c
+ */
+
+#ifndef __SHIM_SDKCONFIG_H__
+#define __SHIM_SDKCONFIG_H__
+
+
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 240
+#define CONFIG_LWIP_MAX_SOCKETS 10
+#define CONFIG_SPIFFS_OBJ_NAME_LEN 32
+/* CONFIG_PM_ENABLE not set, no frequency scaling on host */
+
+
+#endif /* __SHIM_SDKCONFIG_H__ */
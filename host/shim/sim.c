@@ -0,0 +1,814 @@
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "esp_timer.h"
+
+#include "sim.h"
+
+
+/* Every simulated task is a pthread, but only the one holding the run token
+ * (current) executes, the others wait on their condition variable.
+ * The scheduling is the FreeRTOS one on a single core: the highest priority
+ * ready task runs until it blocks or a higher priority task becomes ready,
+ * equal priority tasks are not time sliced.
+ * The time is virtual: running code takes no time, the clock jumps to the
+ * next timeout or esp_timer expiry when every task is blocked. So a replay
+ * gives the same result on every run and on every host, independently
+ * of the host speed. Both ESP32 cores are folded onto this one. */
+
+
+#define SIM_NOTIFY_N 2
+#define SIM_TICK_US (1000000 / configTICK_RATE_HZ)
+#define SIM_NEVER INT64_MAX
+
+
+typedef enum {
+    SIM_NOTIFY_NONE,
+    SIM_NOTIFY_WAITING,
+    SIM_NOTIFY_RECEIVED
+} sim_notify_state;
+
+struct sim_task {
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t prio;
+    BaseType_t core;
+    UBaseType_t number;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_t thread;
+    pthread_cond_t cond;
+    bool ready;
+    bool deleted;
+    uint64_t ready_seq; // FIFO order among the same priority
+    const void *wait_obj; // blocked on this object (NULL: only delay)
+    int64_t wake_us; // block timeout
+    bool woken; // woken by wait_obj, not by the timeout
+    uint32_t notify_value[SIM_NOTIFY_N];
+    sim_notify_state notify_state[SIM_NOTIFY_N];
+    struct sim_task *next;
+};
+
+struct sim_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    int64_t expiry; // SIM_NEVER while stopped
+    uint64_t period_us; // 0 for one-shot
+    struct sim_timer *next;
+};
+
+struct sim_sem {
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+struct sim_queue {
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+/* byte buffer: [free_pos..read_pos) received but not returned,
+ * [read_pos..write_pos) waiting to receive */
+struct sim_ringbuf {
+    uint8_t *buf;
+    size_t size;
+    size_t free_pos;
+    size_t read_pos;
+    size_t write_pos;
+    size_t waiting;
+    size_t held;
+};
+
+
+static void sim_ready(struct sim_task *task);
+static void sim_wake_waiters(const void *obj);
+static bool sim_block(const void *obj, int64_t deadline);
+static int64_t sim_deadline(TickType_t ticks);
+static void sim_yield();
+static void sim_switch();
+static struct sim_task *sim_next();
+static void sim_expire();
+static void sim_advance();
+static void *sim_task_entry(void *arg);
+
+
+/* only for the run token handover, the simulation state
+ * is accessed only by the current task */
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_task *tasks = NULL; // in creation order
+static struct sim_task *current = NULL;
+static struct sim_timer *timers = NULL;
+static int64_t now_us = 0;
+static uint64_t ready_seq = 0;
+static UBaseType_t task_n = 0;
+/* esp_timer callbacks run in the context of the switching task,
+ * they can wake up tasks but the switch happens only after them */
+static bool in_isr = false;
+
+
+void sim_start(const char *name, UBaseType_t prio)
+{
+    struct sim_task *task = calloc(1, sizeof(struct sim_task));
+
+    if(!task) abort();
+
+    strncpy(task->name, name, configMAX_TASK_NAME_LEN - 1);
+    task->prio = prio;
+    task->core = 0;
+    task->number = ++task_n;
+    task->thread = pthread_self();
+    pthread_cond_init(&task->cond, NULL);
+    sim_ready(task);
+    tasks = task;
+    current = task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    struct sim_task *task = calloc(1, sizeof(struct sim_task));
+
+    if(!task) return pdFAIL;
+
+    strncpy(task->name, name, configMAX_TASK_NAME_LEN - 1);
+    task->prio = prio;
+    task->core = core;
+    task->number = ++task_n;
+    task->fn = fn;
+    task->arg = arg;
+    pthread_cond_init(&task->cond, NULL);
+    sim_ready(task);
+
+    struct sim_task **last = &tasks;
+
+    while(*last) last = &(*last)->next;
+
+    *last = task;
+
+    if(handle) *handle = task;
+
+    if(pthread_create(&task->thread, NULL, sim_task_entry, task))
+    {
+        fprintf(stderr, "sim: can't create thread of %s\n", name);
+        abort();
+    }
+
+    pthread_detach(task->thread);
+
+    if(!in_isr && (prio > current->prio)) sim_yield();
+
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if(!task) task = current;
+
+    task->deleted = true;
+    task->ready = false;
+
+    if(task == current) sim_switch();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if(!ticks) taskYIELD();
+    else sim_block(NULL, sim_deadline(ticks));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *prev_wake, TickType_t increment)
+{
+    TickType_t wake = *prev_wake + increment;
+    BaseType_t should_delay = ((int32_t)(wake - xTaskGetTickCount()) > 0);
+    *prev_wake = wake;
+
+    if(should_delay) sim_block(NULL, (int64_t)wake * SIM_TICK_US);
+
+    return should_delay;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return now_us / SIM_TICK_US;
+}
+
+TickType_t xTaskGetTickCountFromISR()
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return current;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandleForCore(BaseType_t core)
+{
+    /* no idle task, the time jumps instead */
+    return NULL;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    if(!task) task = current;
+
+    return task->core;
+}
+
+BaseType_t xPortGetCoreID()
+{
+    return (current->core == tskNO_AFFINITY) ? 0 : current->core;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks()
+{
+    UBaseType_t n = 0;
+
+    for(struct sim_task *task = tasks; task; task = task->next)
+    {
+        if(!task->deleted) n++;
+    }
+
+    return n;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t status_n, uint32_t *total_run_time)
+{
+    UBaseType_t n = 0;
+
+    if(status_n < uxTaskGetNumberOfTasks()) return 0;
+
+    for(struct sim_task *task = tasks; task; task = task->next)
+    {
+        if(task->deleted) continue;
+
+        status[n++] = (TaskStatus_t) {
+            .xHandle = task,
+            .pcTaskName = task->name,
+            .xTaskNumber = task->number,
+            .eCurrentState = (task == current) ? eRunning : (task->ready ? eReady : eBlocked),
+            .uxCurrentPriority = task->prio,
+            .uxBasePriority = task->prio,
+            .ulRunTimeCounter = 0, // the simulated code takes no time
+            .pxStackBase = NULL,
+            .usStackHighWaterMark = 0,
+            .xCoreID = task->core
+        };
+    }
+
+    if(total_run_time) *total_run_time = now_us;
+
+    return n;
+}
+
+uint32_t ulTaskGetRunTimeCounter(TaskHandle_t task)
+{
+    return 0;
+}
+
+void taskYIELD()
+{
+    /* behind the other ready tasks of the same priority */
+    current->ready_seq = ++ready_seq;
+    sim_yield();
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task, UBaseType_t index, uint32_t value, eNotifyAction action, uint32_t *prev_value)
+{
+    sim_notify_state prev_state = task->notify_state[index];
+
+    if(prev_value) *prev_value = task->notify_value[index];
+
+    switch(action)
+    {
+        case eNoAction: break;
+        case eSetBits: task->notify_value[index] |= value; break;
+        case eIncrement: task->notify_value[index]++; break;
+        case eSetValueWithOverwrite: task->notify_value[index] = value; break;
+        case eSetValueWithoutOverwrite:
+            if(prev_state == SIM_NOTIFY_RECEIVED) return pdFAIL;
+
+            task->notify_value[index] = value;
+            break;
+        default: return pdFAIL;
+    }
+
+    task->notify_state[index] = SIM_NOTIFY_RECEIVED;
+
+    if(prev_state == SIM_NOTIFY_WAITING) sim_wake_waiters(&task->notify_value[index]);
+
+    return pdPASS;
+}
+
+BaseType_t xTaskGenericNotifyWait(UBaseType_t index, uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks)
+{
+    struct sim_task *self = current;
+    int64_t deadline = sim_deadline(ticks);
+
+    if(self->notify_state[index] != SIM_NOTIFY_RECEIVED)
+    {
+        self->notify_value[index] &= ~clear_on_entry;
+        self->notify_state[index] = SIM_NOTIFY_WAITING;
+
+        while((self->notify_state[index] != SIM_NOTIFY_RECEIVED) && sim_block(&self->notify_value[index], deadline));
+    }
+
+    if(value) *value = self->notify_value[index];
+
+    if(self->notify_state[index] != SIM_NOTIFY_RECEIVED)
+    {
+        self->notify_state[index] = SIM_NOTIFY_NONE;
+        return pdFALSE;
+    }
+
+    self->notify_value[index] &= ~clear_on_exit;
+    self->notify_state[index] = SIM_NOTIFY_NONE;
+    return pdTRUE;
+}
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct sim_task *self = current;
+    int64_t deadline = sim_deadline(ticks);
+
+    if(!self->notify_value[index])
+    {
+        self->notify_state[index] = SIM_NOTIFY_WAITING;
+
+        while(!self->notify_value[index] && sim_block(&self->notify_value[index], deadline));
+    }
+
+    uint32_t value = self->notify_value[index];
+
+    if(value) self->notify_value[index] = clear_on_exit ? 0 : (value - 1);
+
+    self->notify_state[index] = SIM_NOTIFY_NONE;
+    return value;
+}
+
+void vTaskGenericNotifyGiveFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *need_yield)
+{
+    bool was_isr = in_isr;
+    in_isr = true;
+    xTaskGenericNotify(task, index, 0, eIncrement, NULL);
+    in_isr = was_isr;
+
+    if(need_yield) *need_yield = pdFALSE;
+}
+
+SemaphoreHandle_t sim_sem_create(UBaseType_t max, UBaseType_t initial)
+{
+    struct sim_sem *sem = calloc(1, sizeof(struct sim_sem));
+
+    if(!sem) return NULL;
+
+    sem->max = max;
+    sem->count = initial;
+    return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    int64_t deadline = sim_deadline(ticks);
+
+    while(!sem->count)
+    {
+        if(!sim_block(sem, deadline)) return pdFALSE;
+    }
+
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if(sem->count >= sem->max) return pdFALSE;
+
+    sem->count++;
+    sim_wake_waiters(sem);
+    return pdTRUE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *queue = calloc(1, sizeof(struct sim_queue));
+
+    if(!queue) return NULL;
+
+    queue->items = malloc(length * item_size);
+
+    if(!queue->items)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if(!queue) return;
+
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    int64_t deadline = sim_deadline(ticks);
+
+    while(queue->count >= queue->length)
+    {
+        if(!sim_block(queue, deadline)) return pdFALSE;
+    }
+
+    UBaseType_t i = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[i * queue->item_size], item, queue->item_size);
+    queue->count++;
+    sim_wake_waiters(queue);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    int64_t deadline = sim_deadline(ticks);
+
+    while(!queue->count)
+    {
+        if(!sim_block(queue, deadline)) return pdFALSE;
+    }
+
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    sim_wake_waiters(queue);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type)
+{
+    if(type != RINGBUF_TYPE_BYTEBUF)
+    {
+        fprintf(stderr, "sim: only byte buffer ringbuf supported\n");
+        return NULL;
+    }
+
+    struct sim_ringbuf *ringbuf = calloc(1, sizeof(struct sim_ringbuf));
+
+    if(!ringbuf) return NULL;
+
+    ringbuf->buf = malloc(size);
+
+    if(!ringbuf->buf)
+    {
+        free(ringbuf);
+        return NULL;
+    }
+
+    ringbuf->size = size;
+    return ringbuf;
+}
+
+void vRingbufferDelete(RingbufHandle_t ringbuf)
+{
+    if(!ringbuf) return;
+
+    free(ringbuf->buf);
+    free(ringbuf);
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t ringbuf, const void *data, size_t size, TickType_t ticks)
+{
+    int64_t deadline = sim_deadline(ticks);
+
+    if(size > ringbuf->size) return pdFALSE;
+
+    while((ringbuf->size - ringbuf->waiting - ringbuf->held) < size)
+    {
+        if(!sim_block(ringbuf, deadline)) return pdFALSE;
+    }
+
+    size_t part = ringbuf->size - ringbuf->write_pos;
+
+    if(part > size) part = size;
+
+    memcpy(&ringbuf->buf[ringbuf->write_pos], data, part);
+    memcpy(ringbuf->buf, (const uint8_t*)data + part, size - part);
+    ringbuf->write_pos = (ringbuf->write_pos + size) % ringbuf->size;
+    ringbuf->waiting += size;
+    sim_wake_waiters(ringbuf);
+    return pdTRUE;
+}
+
+void *xRingbufferReceiveUpTo(RingbufHandle_t ringbuf, size_t *item_size, TickType_t ticks, size_t max_size)
+{
+    int64_t deadline = sim_deadline(ticks);
+
+    /* the previous item has to be returned before */
+    if(ringbuf->held || !max_size) return NULL;
+
+    while(!ringbuf->waiting)
+    {
+        if(!sim_block(ringbuf, deadline)) return NULL;
+    }
+
+    /* only contiguous data, the rest after the wrap around at the next call */
+    size_t len = ringbuf->size - ringbuf->read_pos;
+
+    if(len > ringbuf->waiting) len = ringbuf->waiting;
+    if(len > max_size) len = max_size;
+
+    void *item = &ringbuf->buf[ringbuf->read_pos];
+    ringbuf->read_pos = (ringbuf->read_pos + len) % ringbuf->size;
+    ringbuf->waiting -= len;
+    ringbuf->held = len;
+    *item_size = len;
+    return item;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t ringbuf, void *item)
+{
+    ringbuf->free_pos = (ringbuf->free_pos + ringbuf->held) % ringbuf->size;
+    ringbuf->held = 0;
+    sim_wake_waiters(ringbuf);
+}
+
+void vRingbufferGetInfo(RingbufHandle_t ringbuf, UBaseType_t *free, UBaseType_t *read, UBaseType_t *write, UBaseType_t *acquire, UBaseType_t *items_waiting)
+{
+    if(free) *free = ringbuf->free_pos;
+    if(read) *read = ringbuf->read_pos;
+    if(write) *write = ringbuf->write_pos;
+    if(acquire) *acquire = ringbuf->write_pos;
+    if(items_waiting) *items_waiting = ringbuf->waiting;
+}
+
+int64_t esp_timer_get_time()
+{
+    return now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    if(!args || !args->callback || !handle) return ESP_ERR_INVALID_ARG;
+
+    struct sim_timer *timer = calloc(1, sizeof(struct sim_timer));
+
+    if(!timer) return ESP_ERR_NO_MEM;
+
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    timer->name = args->name;
+    timer->expiry = SIM_NEVER;
+    timer->next = timers;
+    timers = timer;
+    *handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if(timer->expiry != SIM_NEVER) return ESP_ERR_INVALID_STATE;
+
+    timer->expiry = now_us + timeout_us;
+    timer->period_us = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if(timer->expiry != SIM_NEVER) return ESP_ERR_INVALID_STATE;
+    if(!period_us) return ESP_ERR_INVALID_ARG;
+
+    timer->expiry = now_us + period_us;
+    timer->period_us = period_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if(timer->expiry == SIM_NEVER) return ESP_ERR_INVALID_STATE;
+
+    timer->expiry = SIM_NEVER;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if(!timer) return ESP_ERR_INVALID_ARG;
+    if(timer->expiry != SIM_NEVER) return ESP_ERR_INVALID_STATE;
+
+    struct sim_timer **link = &timers;
+
+    while(*link && (*link != timer)) link = &(*link)->next;
+
+    if(*link) *link = timer->next;
+
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->expiry != SIM_NEVER;
+}
+
+static void sim_ready(struct sim_task *task)
+{
+    task->ready = true;
+    task->ready_seq = ++ready_seq;
+    task->wait_obj = NULL;
+    task->wake_us = SIM_NEVER;
+}
+
+/* every task waiting on obj checks its condition again */
+static void sim_wake_waiters(const void *obj)
+{
+    bool preempt = false;
+
+    for(struct sim_task *task = tasks; task; task = task->next)
+    {
+        if(task->ready || task->deleted || !task->wait_obj || (task->wait_obj != obj)) continue;
+
+        sim_ready(task);
+        task->woken = true;
+
+        if(task->prio > current->prio) preempt = true;
+    }
+
+    if(preempt && !in_isr) sim_yield();
+}
+
+/* false if the deadline reached without wake up by obj */
+static bool sim_block(const void *obj, int64_t deadline)
+{
+    struct sim_task *self = current;
+
+    if(deadline <= now_us) return false;
+
+    if(in_isr)
+    {
+        fprintf(stderr, "sim: blocking call from timer callback\n");
+        abort();
+    }
+
+    self->ready = false;
+    self->wait_obj = obj;
+    self->wake_us = deadline;
+    self->woken = false;
+    sim_switch();
+    return self->woken;
+}
+
+/* FreeRTOS timeouts end at tick boundary */
+static int64_t sim_deadline(TickType_t ticks)
+{
+    if(ticks == portMAX_DELAY) return SIM_NEVER;
+
+    return ((int64_t)xTaskGetTickCount() + ticks) * SIM_TICK_US;
+}
+
+/* the current task stays ready, but a higher priority may take over */
+static void sim_yield()
+{
+    sim_switch();
+}
+
+static void sim_switch()
+{
+    struct sim_task *self = current;
+    struct sim_task *next;
+    sim_expire();
+
+    while(!(next = sim_next())) sim_advance();
+
+    if(next == self) return;
+
+    pthread_mutex_lock(&sim_mutex);
+    current = next;
+    pthread_cond_signal(&next->cond);
+
+    if(self->deleted)
+    {
+        pthread_mutex_unlock(&sim_mutex);
+        pthread_exit(NULL);
+    }
+
+    while(current != self) pthread_cond_wait(&self->cond, &sim_mutex);
+
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static struct sim_task *sim_next()
+{
+    struct sim_task *next = NULL;
+
+    for(struct sim_task *task = tasks; task; task = task->next)
+    {
+        if(!task->ready || task->deleted) continue;
+
+        if(!next || (task->prio > next->prio) || ((task->prio == next->prio) && (task->ready_seq < next->ready_seq)))
+        {
+            next = task;
+        }
+    }
+
+    return next;
+}
+
+/* run the due timer callbacks in expiry order, then wake the timed out tasks */
+static void sim_expire()
+{
+    struct sim_timer *due;
+
+    do
+    {
+        due = NULL;
+
+        for(struct sim_timer *timer = timers; timer; timer = timer->next)
+        {
+            if((timer->expiry <= now_us) && (!due || (timer->expiry < due->expiry))) due = timer;
+        }
+
+        if(due)
+        {
+            if(due->period_us) due->expiry += due->period_us;
+            else due->expiry = SIM_NEVER;
+
+            in_isr = true;
+            due->callback(due->arg);
+            in_isr = false;
+        }
+    } while(due);
+
+    for(struct sim_task *task = tasks; task; task = task->next)
+    {
+        if(!task->ready && !task->deleted && (task->wake_us <= now_us))
+        {
+            sim_ready(task);
+            task->woken = false;
+        }
+    }
+}
+
+/* every task blocked, jump to the next event */
+static void sim_advance()
+{
+    int64_t next = SIM_NEVER;
+
+    for(struct sim_task *task = tasks; task; task = task->next)
+    {
+        if(!task->ready && !task->deleted && (task->wake_us < next)) next = task->wake_us;
+    }
+
+    for(struct sim_timer *timer = timers; timer; timer = timer->next)
+    {
+        if(timer->expiry < next) next = timer->expiry;
+    }
+
+    if(next == SIM_NEVER)
+    {
+        fprintf(stderr, "sim: every task blocked forever at %lldus\n", (long long)now_us);
+        abort();
+    }
+
+    if(next > now_us) now_us = next;
+
+    sim_expire();
+}
+
+static void *sim_task_entry(void *arg)
+{
+    struct sim_task *self = (struct sim_task*)arg;
+    pthread_mutex_lock(&sim_mutex);
+
+    while(current != self) pthread_cond_wait(&self->cond, &sim_mutex);
+
+    pthread_mutex_unlock(&sim_mutex);
+    self->fn(self->arg);
+    /* returning from a task function is an error in FreeRTOS */
+    fprintf(stderr, "sim: task %s returned\n", self->name);
+    vTaskDelete(NULL);
+    return NULL;
+}
@@ -0,0 +1,17 @@
+/*
+ * Deterministic single core FreeRTOS simulation of the host build
+ */
+
+#ifndef __SHIM_SIM_H__
+#define __SHIM_SIM_H__
+
+
+#include "freertos/FreeRTOS.h"
+
+
+/* the calling thread becomes the first simulated task,
+ * it has to be called before any other FreeRTOS or esp_timer function */
+void sim_start(const char *name, UBaseType_t prio);
+
+
+#endif /* __SHIM_SIM_H__ */
@@ -0,0 +1,621 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "esp_http_server.h"
+#include "app_config.h"
+#include "app_tools.h"
+#include "dsp.h"
+#include "color.h"
+#include "lights.h"
+#include "led_i2s.h"
+#include "audio_profile.h"
+#include "tasks.h"
+#include "web.h"
+#if TESTS_STORAGE
+#include "storage.h"
+#endif
+
+
+#define TESTS_PIXEL_N 300
+/* not a multiple of the ring size, the writes wrap inside a packet */
+#define TESTS_DSP_PACKET_SIZE (333 * AUDIO_CHANNEL_N * AUDIO_SAMPLE_BYTE_LEN)
+/* FFT bins of the test tones, whole periods in the FFT input */
+#define TESTS_DSP_BIN_A 40
+#define TESTS_DSP_BIN_B 100
+/* RMT symbols of a WS281x byte */
+#define TESTS_WS281X_BYTE_SYMBOL_N 8
+/* the strip of each case, cases of one run must not share a strip (sizes are set once) */
+#define TESTS_STRIP_WEB_WS 0
+#define TESTS_STRIP_STORAGE 1
+
+#define TESTS_CHECK(cond, ...) \
+    do \
+    { \
+        if(!(cond)) \
+        { \
+            fprintf(out, "    %s:%d: ", __func__, __LINE__); \
+            fprintf(out, __VA_ARGS__); \
+            fprintf(out, "\n"); \
+            return false; \
+        } \
+    } while(0)
+
+
+typedef struct {
+    const char *name;
+    bool (*fn)();
+} tests_case;
+
+
+static bool tests_color();
+static bool tests_mled_i2s();
+static bool tests_ws281x();
+static bool tests_lights_output();
+static bool tests_apa102_scale();
+static bool tests_dsp_ring();
+static bool tests_web_ws();
+#if TESTS_STORAGE
+static bool tests_storage();
+#endif
+static uint32_t tests_gamma(uint16_t value);
+static void tests_dsp_tones(size_t bin_l, size_t bin_r, size_t byte_n);
+static size_t tests_dsp_peak(bool is_right);
+static const httpd_shim_frame *tests_web_ws_msg(uint8_t sid, uint8_t arg, size_t len);
+
+
+static const tests_case tests[] = {
+    {"color", tests_color},
+    {"mled_i2s", tests_mled_i2s},
+    {"ws281x", tests_ws281x},
+    {"lights_output", tests_lights_output},
+    {"apa102_scale", tests_apa102_scale},
+    {"dsp_ring", tests_dsp_ring},
+    {"web_ws", tests_web_ws},
+#if TESTS_STORAGE
+    {"storage", tests_storage}
+#endif
+};
+/* results go here, stdout is muted, the modules print there */
+static FILE *out = NULL;
+static uint8_t dsp_packet[TESTS_DSP_PACKET_SIZE];
+/* frame index of the tones, the phase goes on between the calls */
+static size_t dsp_frame_i = 0;
+/* the strips of the parallel output, a lane each */
+static mled_strip i2s_strips[MLED_I2S_LANE_N];
+static uint8_t i2s_pixels[MLED_I2S_LANE_N][TESTS_PIXEL_N * 3];
+static mled_i2s_slot i2s_buf[MLED_I2S_SLOT_N(TESTS_PIXEL_N * 3)];
+/* the symbols of the LUT encoder, a chunk more for the overrun check */
+static rmt_symbol_word_t ws281x_symbols[(TESTS_PIXEL_N * 3 + 4) * TESTS_WS281X_BYTE_SYMBOL_N];
+/* a strip of the output stage only, no zones (not in mled_channels) */
+static uint16_t output_frame[TESTS_PIXEL_N * LIGHTS_CH_N];
+static uint8_t output_data[TESTS_PIXEL_N * MLED_PIXEL_SIZE_MAX];
+static uint8_t output_sent[TESTS_PIXEL_N * MLED_PIXEL_SIZE_MAX];
+static color_rgb repeat_colors[] = {
+    {.r = 10, .g = 20, .b = 30},
+    {.r = 40, .g = 50, .b = 60}
+};
+
+
+int main(int argc, char *argv[])
+{
+    /* optional: only the case with this name */
+    const char *name = (argc > 1) ? argv[1] : NULL;
+    size_t run_n = 0;
+    size_t fail_n = 0;
+    out = fdopen(dup(STDOUT_FILENO), "w");
+
+    if(!out || !freopen("/dev/null", "w", stdout)) return 1;
+
+    /* above the application tasks: they never run, only their locks are used */
+    sim_start("tests", configMAX_PRIORITIES - 1);
+    esp_log_level_set("*", ESP_LOG_NONE);
+    tasks_create();
+
+    for(size_t i = 0; i < (sizeof(tests) / sizeof(tests[0])); i++)
+    {
+        if(name && strcmp(tests[i].name, name)) continue;
+
+        bool pass = tests[i].fn();
+        fprintf(out, "%-16s %s\n", tests[i].name, pass ? "OK" : "FAILED");
+        fflush(out);
+        run_n++;
+
+        if(!pass) fail_n++;
+    }
+
+    if(!run_n) fprintf(out, "no test: %s\n", name);
+
+    fclose(out);
+    return (!run_n || fail_n) ? 1 : 0;
+}
+
+/* the whole wheel on a grid, fixed-point against the float reference */
+static bool tests_color()
+{
+    color_hsl hsl;
+    color_rgb ref, fix;
+
+    for(int hue = 0; hue < 720; hue++)
+    {
+        for(int sat = 0; sat <= 128; sat++)
+        {
+            for(int lum = 0; lum <= 128; lum++)
+            {
+                hsl = (color_hsl) {.hue = hue * 0.5f, .sat = sat / 128.0f, .lum = lum / 128.0f};
+                ref = color_hsl_to_rgb(hsl);
+                fix = color_hsl_fix_to_rgb(color_hsl_to_fix(hsl));
+                TESTS_CHECK((abs(ref.r - fix.r) <= 1) && (abs(ref.g - fix.g) <= 1) && (abs(ref.b - fix.b) <= 1),
+                    "hsl %.1f %.4f %.4f: %d %d %d, reference: %d %d %d",
+                    hsl.hue, hsl.sat, hsl.lum, fix.r, fix.g, fix.b, ref.r, ref.g, ref.b);
+            }
+        }
+    }
+
+    /* the bulk API gives the same as one by one */
+    color_hsl_fix px_fix[TESTS_PIXEL_N];
+    color_rgb px_rgb[TESTS_PIXEL_N];
+
+    for(size_t i = 0; i < TESTS_PIXEL_N; i++)
+    {
+        px_fix[i] = color_hsl_to_fix((color_hsl) {.hue = (360.0f * i) / TESTS_PIXEL_N, .sat = 1.0f, .lum = (0.5f * i) / TESTS_PIXEL_N});
+    }
+
+    color_hsl_fix_to_rgb_n(px_fix, px_rgb, TESTS_PIXEL_N);
+
+    for(size_t i = 0; i < TESTS_PIXEL_N; i++)
+    {
+        fix = color_hsl_fix_to_rgb(px_fix[i]);
+        TESTS_CHECK(!memcmp(&fix, &px_rgb[i], sizeof(fix)), "pixel %u: %d %d %d, one by one: %d %d %d",
+            (unsigned)i, px_rgb[i].r, px_rgb[i].g, px_rgb[i].b, fix.r, fix.g, fix.b);
+    }
+
+    return true;
+}
+
+/* random strips of different length to the bus slots, then back per lane */
+static bool tests_mled_i2s()
+{
+    size_t byte_n = TESTS_PIXEL_N * 3;
+    mled_i2s_slot *slot;
+    uint8_t expect;
+    srand(1);
+
+    for(size_t lane = 0; lane < MLED_I2S_LANE_N; lane++)
+    {
+        for(size_t i = 0; i < byte_n; i++)
+        {
+            i2s_pixels[lane][i] = rand();
+        }
+
+        i2s_strips[lane].pixels.sent = i2s_pixels[lane];
+        /* lane 0 the longest, the last is empty */
+        i2s_strips[lane].pixels.pixel_n = (TESTS_PIXEL_N * (MLED_I2S_LANE_N - 1 - lane)) / (MLED_I2S_LANE_N - 1);
+        i2s_strips[lane].pixels.data_size = i2s_strips[lane].pixels.pixel_n * 3;
+    }
+
+    mled_i2s_frame_init(i2s_buf, byte_n);
+    mled_i2s_encode(i2s_strips, MLED_I2S_LANE_N, i2s_buf, byte_n);
+
+    for(size_t lane = 0; lane < MLED_I2S_LANE_N; lane++)
+    {
+        for(size_t i = 0; i < byte_n; i++)
+        {
+            for(uint8_t bit = 0; bit < 8; bit++)
+            {
+                slot = &i2s_buf[((i * 8) + bit) * MLED_I2S_BIT_SLOT_N];
+                expect = (i < i2s_strips[lane].pixels.data_size) ? (i2s_pixels[lane][i] >> (7 - bit)) & 1 : 0;
+                /* 1, data, data, 0 */
+                TESTS_CHECK(((slot[0] >> lane) & 1) && (((slot[1] >> lane) & 1) == expect) && (((slot[2] >> lane) & 1) == expect) && !((slot[3] >> lane) & 1),
+                    "lane %u byte %u bit %u: slots %x %x %x %x, data bit: %u",
+                    (unsigned)lane, (unsigned)i, bit, slot[0], slot[1], slot[2], slot[3], expect);
+            }
+        }
+    }
+
+    /* the reset code is low on every lane */
+    for(size_t i = byte_n * MLED_I2S_BYTE_SLOT_N; i < MLED_I2S_SLOT_N(byte_n); i++)
+    {
+        TESTS_CHECK(!i2s_buf[i], "reset slot %u: %x", (unsigned)i, i2s_buf[i]);
+    }
+
+    return true;
+}
+
+/* random bytes to RMT symbols in chunks of changing size like the RMT ISR asks for them,
+ * restarting at odd bytes: the bit codes of the bytes encoder config, MSB first */
+static bool tests_ws281x()
+{
+#if MLED_WS281X_LUT
+    size_t byte_n = TESTS_PIXEL_N * 3;
+    size_t written = 0;
+    size_t symbols_free;
+    size_t symbol_n;
+    bool done = false;
+    const rmt_symbol_word_t *expect;
+    srand(3);
+
+    for(size_t i = 0; i < byte_n; i++)
+    {
+        i2s_pixels[0][i] = rand();
+    }
+
+    memset(ws281x_symbols, 0xFF, sizeof(ws281x_symbols));
+    mled_ws281x_lut_build();
+
+    /* less than a byte: nothing */
+    symbol_n = mled_ws281x_encode(i2s_pixels[0], byte_n, 0, TESTS_WS281X_BYTE_SYMBOL_N - 1, ws281x_symbols, &done, NULL);
+    TESTS_CHECK(!symbol_n && !done, "%u symbols to %u free, done: %d", (unsigned)symbol_n, TESTS_WS281X_BYTE_SYMBOL_N - 1, done);
+
+    for(size_t call = 0; !done; call++)
+    {
+        /* 1..3 bytes and a part of one */
+        symbols_free = TESTS_WS281X_BYTE_SYMBOL_N + ((call * 5) % (3 * TESTS_WS281X_BYTE_SYMBOL_N));
+        symbol_n = mled_ws281x_encode(i2s_pixels[0], byte_n, written, symbols_free, &ws281x_symbols[written], &done, NULL);
+        TESTS_CHECK(symbol_n && (symbol_n <= symbols_free) && !(symbol_n % TESTS_WS281X_BYTE_SYMBOL_N),
+            "call %u at %u: %u symbols to %u free", (unsigned)call, (unsigned)written, (unsigned)symbol_n, (unsigned)symbols_free);
+        written += symbol_n;
+
+        for(size_t i = written; i < (written + TESTS_WS281X_BYTE_SYMBOL_N); i++)
+        {
+            TESTS_CHECK(ws281x_symbols[i].val == UINT32_MAX, "call %u: symbol %u written after the %u returned",
+                (unsigned)call, (unsigned)i, (unsigned)written);
+        }
+    }
+
+    TESTS_CHECK(written == (byte_n * TESTS_WS281X_BYTE_SYMBOL_N), "done after %u symbols", (unsigned)written);
+
+    for(size_t i = 0; i < byte_n; i++)
+    {
+        for(uint8_t bit = 0; bit < 8; bit++)
+        {
+            expect = ((i2s_pixels[0][i] >> (7 - bit)) & 1) ? &mled_ws281x_encoder_cfg.bit1 : &mled_ws281x_encoder_cfg.bit0;
+            TESTS_CHECK(ws281x_symbols[(i * TESTS_WS281X_BYTE_SYMBOL_N) + bit].val == expect->val,
+                "byte %u (%02x) bit %u: %08x, bit code: %08x", (unsigned)i, i2s_pixels[0][i], bit,
+                ws281x_symbols[(i * TESTS_WS281X_BYTE_SYMBOL_N) + bit].val, expect->val);
+        }
+    }
+#endif
+
+    return true;
+}
+
+/* random frame to GRBW, then to GRB: the white is the common part of the channels
+ * after the gamma LUT, the rest in the wire byte order, the rounded output (no dither cycle) */
+static bool tests_lights_output()
+{
+    lights_zone_list list = {.frame = output_frame};
+    mled_strip strip = {
+        .pixels = {.data = output_data, .sent = output_sent, .pixel_n = TESTS_PIXEL_N},
+        .rgb_order = {.i_r = 1, .i_g = 0, .i_b = 2, .i_w = 3, .white = true},
+        .type = MLED_TYPE_WS281X
+    };
+    uint32_t ch[LIGHTS_CH_N];
+    uint32_t white;
+    uint8_t *px;
+    srand(2);
+
+    for(size_t i = 0; i < (TESTS_PIXEL_N * LIGHTS_CH_N); i++)
+    {
+        output_frame[i] = rand();
+    }
+
+    /* the extremes: black, full scale, a gray */
+    for(size_t i = 0; i < LIGHTS_CH_N; i++)
+    {
+        output_frame[i] = 0;
+        output_frame[LIGHTS_CH_N + i] = UINT16_MAX;
+        output_frame[(2 * LIGHTS_CH_N) + i] = 0x8000;
+    }
+
+    lights_set_gamma(LIGHTS_GAMMA);
+    TESTS_CHECK(lights_output(&list, &strip), "first GRBW frame not changed");
+
+    for(size_t i = 0; i < TESTS_PIXEL_N; i++)
+    {
+        for(uint8_t c = 0; c < LIGHTS_CH_N; c++)
+        {
+            ch[c] = tests_gamma(output_frame[(i * LIGHTS_CH_N) + c]);
+        }
+
+        white = ch[LIGHTS_CH_R];
+
+        if(ch[LIGHTS_CH_G] < white) white = ch[LIGHTS_CH_G];
+        if(ch[LIGHTS_CH_B] < white) white = ch[LIGHTS_CH_B];
+
+        px = &output_data[i * 4];
+        TESTS_CHECK(px[3] == ((white + 128) >> 8), "pixel %u white: %u, min: %u", (unsigned)i, px[3], (unsigned)white);
+        TESTS_CHECK((px[1] == ((ch[LIGHTS_CH_R] - white + 128) >> 8)) && (px[0] == ((ch[LIGHTS_CH_G] - white + 128) >> 8))
+            && (px[2] == ((ch[LIGHTS_CH_B] - white + 128) >> 8)),
+            "pixel %u GRB: %u %u %u, 8.8: %u %u %u, white: %u", (unsigned)i, px[0], px[1], px[2],
+            (unsigned)ch[LIGHTS_CH_G], (unsigned)ch[LIGHTS_CH_R], (unsigned)ch[LIGHTS_CH_B], (unsigned)white);
+    }
+
+    /* without white the channels as they are */
+    strip.rgb_order = (mled_rgb_order) {.i_r = 1, .i_g = 0, .i_b = 2};
+    list.frame_sent = false;
+    TESTS_CHECK(lights_output(&list, &strip), "first GRB frame not changed");
+
+    for(size_t i = 0; i < TESTS_PIXEL_N; i++)
+    {
+        for(uint8_t c = 0; c < LIGHTS_CH_N; c++)
+        {
+            ch[c] = (tests_gamma(output_frame[(i * LIGHTS_CH_N) + c]) + 128) >> 8;
+        }
+
+        px = &output_data[i * 3];
+        TESTS_CHECK((px[1] == ch[LIGHTS_CH_R]) && (px[0] == ch[LIGHTS_CH_G]) && (px[2] == ch[LIGHTS_CH_B]),
+            "pixel %u GRB: %u %u %u, expected: %u %u %u", (unsigned)i, px[0], px[1], px[2],
+            (unsigned)ch[LIGHTS_CH_G], (unsigned)ch[LIGHTS_CH_R], (unsigned)ch[LIGHTS_CH_B]);
+    }
+
+    return true;
+}
+
+/* every 8.8 channel max up to the LUT full scale: the lowest brightness which keeps the
+ * scaled channels in 255.0, so the dithered output fits 16 bit and the wire byte */
+static bool tests_apa102_scale()
+{
+    uint32_t bri, scaled;
+
+    for(uint32_t max = 0; max <= (255 * 256); max++)
+    {
+        bri = lights_apa102_bri(max);
+        TESTS_CHECK(bri <= MLED_APA102_BRIGHTNESS_MAX, "max %u: brightness %u", (unsigned)max, (unsigned)bri);
+        TESTS_CHECK(!max == !bri, "max %u: brightness %u", (unsigned)max, (unsigned)bri);
+
+        if(!max) continue;
+
+        scaled = lights_apa102_scale(max, bri);
+        TESTS_CHECK(scaled <= (255 * 256), "max %u: brightness %u, scaled %u", (unsigned)max, (unsigned)bri, (unsigned)scaled);
+        TESTS_CHECK((scaled + UINT8_MAX) <= UINT16_MAX, "max %u: brightness %u, scaled %u", (unsigned)max, (unsigned)bri, (unsigned)scaled);
+        TESTS_CHECK((bri == 1) || (lights_apa102_scale(max, bri - 1) > (255 * 256)),
+            "max %u: brightness %u, %u fits too", (unsigned)max, (unsigned)bri, (unsigned)(bri - 1));
+        /* the dimmer channels of the pixel below the brightest */
+        TESTS_CHECK(lights_apa102_scale(max - 1, bri) <= scaled, "max %u: brightness %u, not monotonic", (unsigned)max, (unsigned)bri);
+    }
+
+    return true;
+}
+
+/* wrapping writes of two tones, the FFT input has to be the latest ring content per channel */
+static bool tests_dsp_ring()
+{
+    size_t peak;
+    TESTS_CHECK(dsp_fft_buf_create(), "no memory");
+
+    /* a whole ring and a half, the oldest data is in the middle */
+    tests_dsp_tones(TESTS_DSP_BIN_A, TESTS_DSP_BIN_B, DSP_FFT_BUF_N + (DSP_FFT_BUF_N / 2));
+    dsp_work_buf_init();
+    dsp_fft_do();
+    dsp_fft_finalize();
+    peak = tests_dsp_peak(false);
+    TESTS_CHECK(peak == TESTS_DSP_BIN_A, "left peak bin: %u, tone: %d", (unsigned)peak, TESTS_DSP_BIN_A);
+    peak = tests_dsp_peak(true);
+    TESTS_CHECK(peak == TESTS_DSP_BIN_B, "right peak bin: %u, tone: %d", (unsigned)peak, TESTS_DSP_BIN_B);
+
+    /* the channels swapped: the old tones completely overwritten */
+    tests_dsp_tones(TESTS_DSP_BIN_B, TESTS_DSP_BIN_A, DSP_FFT_BUF_N);
+    dsp_work_buf_init();
+    dsp_fft_do();
+    dsp_fft_finalize();
+    peak = tests_dsp_peak(false);
+    TESTS_CHECK(peak == TESTS_DSP_BIN_B, "overwritten left peak bin: %u, tone: %d", (unsigned)peak, TESTS_DSP_BIN_B);
+    peak = tests_dsp_peak(true);
+    TESTS_CHECK(peak == TESTS_DSP_BIN_A, "overwritten right peak bin: %u, tone: %d", (unsigned)peak, TESTS_DSP_BIN_A);
+
+    for(size_t i = 0; i < DSP_FFT_RES_N; i++)
+    {
+        float res = dsp_fft_get_res(false)[i];
+        TESTS_CHECK((res >= 0.0f) && (res <= 1.0f), "left bin %u out of range: %f", (unsigned)i, res);
+        res = dsp_fft_get_res(true)[i];
+        TESTS_CHECK((res >= 0.0f) && (res <= 1.0f), "right bin %u out of range: %f", (unsigned)i, res);
+    }
+
+    dsp_fft_buf_del();
+    return true;
+}
+
+/* the handshake and the replies decoded like the web UI (com.js) does */
+static bool tests_web_ws()
+{
+    httpd_shim_stat stat;
+    const httpd_shim_frame *frame;
+    size_t pixel_n;
+    audio_profile_id selected, active;
+    const uint8_t *p;
+    lights_zone_chain *zone;
+
+    mled_channels[TESTS_STRIP_WEB_WS].rgb_order = (mled_rgb_order) {.i_r = 1, .i_g = 0, .i_b = 2};
+    lights_set_strip_size(TESTS_STRIP_WEB_WS, 10);
+    zone = lights_new_zone(TESTS_STRIP_WEB_WS, 6);
+    TESTS_CHECK(zone, "zone 0 not created");
+    zone->shader.cfg.shader_single.color = (color_rgb) {.r = 1, .g = 2, .b = 3};
+    zone = lights_new_zone(TESTS_STRIP_WEB_WS, 4);
+    TESTS_CHECK(zone, "zone 1 not created");
+    zone->shader.type = SHADER_REPEAT;
+    zone->shader.cfg.shader_repeat = (lights_shader_cfg_repeat) {
+        .colors = repeat_colors,
+        .color_n = sizeof(repeat_colors) / sizeof(repeat_colors[0])
+    };
+
+    httpd_req_t req = {
+        .method = HTTP_GET,
+        .sockfd = 1
+    };
+    httpd_shim_stat_take(&stat);
+    web_ws(&req);
+    /* strips, zones of the only strip with zones, a shader per zone, audio profiles */
+    TESTS_CHECK(httpd_shim_frame_get(4) && !httpd_shim_frame_get(5), "handshake frames: not 5");
+
+    frame = httpd_shim_frame_get(0);
+    TESTS_CHECK(frame && (frame->payload[0] == WEB_WS_CID_STRIP_CFG), "no strip config");
+    p = &frame->payload[1 + (TESTS_STRIP_WEB_WS * (sizeof(size_t) + MLED_PIXEL_SIZE_MAX))];
+    memcpy(&pixel_n, p, sizeof(pixel_n));
+    p += sizeof(size_t);
+    TESTS_CHECK(pixel_n == 10, "strip pixel_n: %u", (unsigned)pixel_n);
+    TESTS_CHECK(!memcmp(p, "GRB\0", MLED_PIXEL_SIZE_MAX), "rgb order: %.4s", p);
+
+    frame = httpd_shim_frame_get(1);
+    TESTS_CHECK(frame && (frame->payload[0] == WEB_WS_CID_ZONE_CFG), "no zone config");
+    TESTS_CHECK((frame->len == (2 + 2 * sizeof(size_t))) && (frame->payload[1] == TESTS_STRIP_WEB_WS),
+        "zone config len: %u, strip: %u", (unsigned)frame->len, frame->payload[1]);
+    memcpy(&pixel_n, &frame->payload[2 + sizeof(size_t)], sizeof(pixel_n));
+    TESTS_CHECK(pixel_n == 4, "zone 1 pixel_n: %u", (unsigned)pixel_n);
+
+    frame = httpd_shim_frame_get(2);
+    TESTS_CHECK(frame && (frame->len == 7), "single shader len: %u", frame ? (unsigned)frame->len : 0);
+    TESTS_CHECK(!memcmp(frame->payload, (uint8_t[]) {WEB_WS_CID_SHADER_CFG, TESTS_STRIP_WEB_WS, 0, SHADER_SINGLE, 1, 2, 3}, 7),
+        "single shader: %x %x %x %x", frame->payload[0], frame->payload[1], frame->payload[2], frame->payload[3]);
+
+    frame = httpd_shim_frame_get(3);
+    TESTS_CHECK(frame && (frame->len == 4 + sizeof(repeat_colors)), "repeat shader len: %u", frame ? (unsigned)frame->len : 0);
+    TESTS_CHECK((frame->payload[2] == 1) && (frame->payload[3] == SHADER_REPEAT) && !memcmp(&frame->payload[4], repeat_colors, sizeof(repeat_colors)),
+        "repeat shader zone: %u, type: %u", frame->payload[2], frame->payload[3]);
+
+    /* the names of every profile, zero ended */
+    frame = httpd_shim_frame_get(4);
+    tasks_audio_profile(&selected, &active);
+    TESTS_CHECK(frame && (frame->payload[0] == WEB_WS_CID_AUDIO_PROFILE), "no audio profile");
+    TESTS_CHECK((frame->payload[1] == selected) && (frame->payload[2] == active), "audio profile selected: %u, active: %u",
+        frame->payload[1], frame->payload[2]);
+    p = &frame->payload[3];
+
+    for(uint8_t i = 0; i < AUDIO_PROFILE_MAX; i++)
+    {
+        TESTS_CHECK(!strcmp((const char*)p, audio_profile_get(i)->name), "audio profile %u name: %s", i, p);
+        p += strlen((const char*)p) + 1;
+    }
+
+    TESTS_CHECK(p == &frame->payload[frame->len], "audio profile len: %u", (unsigned)frame->len);
+
+    /* the limiter meter: current and max reduction */
+    frame = tests_web_ws_msg(WEB_WS_SID_AUDIO_METER_GET, 0, 1);
+    TESTS_CHECK(frame && (frame->payload[0] == WEB_WS_CID_AUDIO_METER) && (frame->len == (1 + 2 * sizeof(float))),
+        "audio meter len: %u", frame ? (unsigned)frame->len : 0);
+
+    /* a select answered with the profiles, an invalid one changes nothing */
+    frame = tests_web_ws_msg(WEB_WS_SID_AUDIO_PROFILE_SET, AUDIO_PROFILE_ROBUST, 2);
+    TESTS_CHECK(frame && (frame->payload[0] == WEB_WS_CID_AUDIO_PROFILE) && (frame->payload[1] == AUDIO_PROFILE_ROBUST),
+        "audio profile not selected");
+    frame = tests_web_ws_msg(WEB_WS_SID_AUDIO_PROFILE_SET, AUDIO_PROFILE_MAX, 2);
+    TESTS_CHECK(frame && (frame->payload[0] == WEB_WS_CID_AUDIO_PROFILE) && (frame->payload[1] == AUDIO_PROFILE_ROBUST),
+        "invalid audio profile selected");
+    tasks_audio_profile_select(AUDIO_PROFILE_DEFAULT, false);
+    return true;
+}
+
+#if TESTS_STORAGE
+/* a config.json with every strip field, an invalid strip skipped */
+static bool tests_storage()
+{
+    static const char config[] =
+        "{\"audio\": {\"profile\": \"low_latency\"},"
+        " \"lights\": {\"gamma\": 2.2, \"strips\": ["
+        "  {\"pixel_n\": 30, \"rgb_order\": \"RRB\", \"zones\": [{\"pixel_n\": 30}]},"
+        "  {\"pixel_n\": 20, \"rgb_order\": \"BRGW\", \"zones\": ["
+        "   {\"pixel_n\": 12, \"shader\": {\"type\": 0, \"color\": {\"r\": 7, \"g\": 8, \"b\": 9}}},"
+        "   {\"pixel_n\": 8, \"shader\": {\"type\": 1, \"colors\": [{\"r\": 1, \"g\": 2, \"b\": 3}, {\"r\": 4, \"g\": 5, \"b\": 6}]}}]}]}}";
+    audio_profile_id selected, active;
+    lights_zone_chain *zone;
+
+    FILE *file = fopen(STORAGE_PATH_CONFIG, "w");
+    TESTS_CHECK(file, "%s not writable", STORAGE_PATH_CONFIG);
+    fputs(config, file);
+    fclose(file);
+    /* the first strip entry is invalid (skipped), the second is TESTS_STRIP_STORAGE */
+    storage_config_parse();
+    remove(STORAGE_PATH_CONFIG);
+
+    tasks_audio_profile(&selected, &active);
+    TESTS_CHECK(selected == AUDIO_PROFILE_LOW_LATENCY, "audio profile: %d", selected);
+    TESTS_CHECK(fabsf(lights_get_gamma() - 2.2f) < 0.001f, "gamma: %f", lights_get_gamma());
+
+    mled_strip *strip = &mled_channels[TESTS_STRIP_STORAGE];
+    TESTS_CHECK(strip->pixels.pixel_n == 20, "pixel_n: %u", (unsigned)strip->pixels.pixel_n);
+    TESTS_CHECK((strip->rgb_order.i_r == 1) && (strip->rgb_order.i_g == 2) && (strip->rgb_order.i_b == 0)
+        && strip->rgb_order.white && (strip->rgb_order.i_w == 3),
+        "rgb order: r %u g %u b %u w %u", strip->rgb_order.i_r, strip->rgb_order.i_g, strip->rgb_order.i_b, strip->rgb_order.i_w);
+    TESTS_CHECK(lights_zones[TESTS_STRIP_STORAGE].zone_n == 2, "zone_n: %u", (unsigned)lights_zones[TESTS_STRIP_STORAGE].zone_n);
+
+    zone = lights_zones[TESTS_STRIP_STORAGE].first;
+    TESTS_CHECK((zone->frame_buf.pixel_n == 12) && (zone->shader.type == SHADER_SINGLE), "zone 0 pixel_n: %u, shader: %d",
+        (unsigned)zone->frame_buf.pixel_n, zone->shader.type);
+    color_rgb color = zone->shader.cfg.shader_single.color;
+    TESTS_CHECK((color.r == 7) && (color.g == 8) && (color.b == 9), "zone 0 color: %d %d %d", color.r, color.g, color.b);
+
+    zone = zone->next;
+    TESTS_CHECK((zone->frame_buf.pixel_n == 8) && (zone->shader.type == SHADER_REPEAT), "zone 1 pixel_n: %u, shader: %d",
+        (unsigned)zone->frame_buf.pixel_n, zone->shader.type);
+    lights_shader_cfg_repeat *repeat = &zone->shader.cfg.shader_repeat;
+    TESTS_CHECK((repeat->color_n == 2) && (repeat->colors[1].r == 4) && (repeat->colors[1].b == 6), "zone 1 colors: %u",
+        (unsigned)repeat->color_n);
+
+    tasks_audio_profile_select(AUDIO_PROFILE_DEFAULT, false);
+    return true;
+}
+#endif
+
+/* the 8.8 output of the gamma LUT, built the same way as lights_set_gamma */
+static uint32_t tests_gamma(uint16_t value)
+{
+    float x = (value >> (16 - LIGHTS_GAMMA_LUT_BITS)) / (float)((1 << LIGHTS_GAMMA_LUT_BITS) - 1);
+    return lrintf(powf(x, lights_get_gamma()) * 255.0f * 256.0f);
+}
+
+/* interleaved full scale / 4 sines with whole periods in DSP_FFT_IN_N frames */
+static void tests_dsp_tones(size_t bin_l, size_t bin_r, size_t byte_n)
+{
+    int16_t *frame;
+
+    while(byte_n)
+    {
+        size_t size = (byte_n < sizeof(dsp_packet)) ? byte_n : sizeof(dsp_packet);
+        frame = (int16_t*)dsp_packet;
+
+        for(size_t i = 0; i < (size / (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N)); i++)
+        {
+            float phase = (2 * M_PI * (dsp_frame_i % DSP_FFT_IN_N)) / DSP_FFT_IN_N;
+            frame[0] = 8192.0f * sinf(phase * bin_l);
+            frame[1] = 8192.0f * sinf(phase * bin_r);
+            frame += AUDIO_CHANNEL_N;
+            dsp_frame_i++;
+        }
+
+        dsp_new_data(dsp_packet, size);
+        byte_n -= size;
+    }
+}
+
+static size_t tests_dsp_peak(bool is_right)
+{
+    float *res = dsp_fft_get_res(is_right);
+    size_t peak = 0;
+
+    for(size_t i = 1; i < DSP_FFT_RES_N; i++)
+    {
+        if(res[i] > res[peak]) peak = i;
+    }
+
+    return peak;
+}
+
+/* a client message of len bytes (the SID and the argument), the last reply */
+static const httpd_shim_frame *tests_web_ws_msg(uint8_t sid, uint8_t arg, size_t len)
+{
+    httpd_shim_stat stat;
+    uint8_t msg[] = {sid, arg};
+    httpd_req_t req = {
+        .method = HTTP_POST,
+        .sockfd = 1,
+        .ws_payload = msg,
+        .ws_len = len
+    };
+    httpd_shim_stat_take(&stat);
+    web_ws(&req);
+
+    return httpd_shim_frame_get(0);
+}
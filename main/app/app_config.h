@@ -19,10 +19,52 @@
 
 /* onboard blue LED */
 #define PIN_LED_BLUE        GPIO_NUM_2 // VDD3P3_RTC
-/* used matrix LED strip pins */
+/* used matrix LED strip pins, every strip has an own RMT TX channel */
 #define PIN_MLED_STRIP_0    GPIO_NUM_12 // VDD3P3_RTC
 #define PIN_MLED_STRIP_1    GPIO_NUM_14 // VDD3P3_RTC
+/* number of strips, max. the TX capable RMT channels (ESP32: 8),
+ * MLED_STRIP_PINS and MLED_STRIP_MEM_BLOCKS need one item per strip */
 #define MLED_STRIP_N        2
+#define MLED_STRIP_PINS     {PIN_MLED_STRIP_0, PIN_MLED_STRIP_1}
+/* RMT memory blocks (SOC_RMT_MEM_WORDS_PER_CHANNEL symbols each) of the strips,
+ * a strip with more blocks needs less ISR refill, the sum max. the RMT channels,
+ * a clocked strip needs none */
+#define MLED_STRIP_MEM_BLOCKS {4, 4}
+/* clock pins of the clocked strips (APA102, SK9822), sent by SPI DMA instead of the RMT,
+ * GPIO_NUM_NC: WS281x strip, max. 2 clocked strips (SPI2, SPI3), not with the I2S engine */
+#define MLED_STRIP_CLK_PINS {GPIO_NUM_NC, GPIO_NUM_NC}
+/* SPI clock of the clocked strips, a pixel is 32 clocks */
+#define MLED_APA102_CLOCK_HZ 8000000
+/* max. pixels of a clocked strip, the SPI DMA transfer sized to it */
+#define MLED_APA102_PIXEL_N_MAX 1000
+/* LED strip output engine, 0: an RMT channel per strip,
+ * 1: the I2S peripheral in parallel LCD mode, its DMA clocks all strips at once,
+ * a data line per strip: MLED_STRIP_N has to be 8 or 16 (the bus width) */
+#define MLED_I2S_PARALLEL   0
+/* I2S engine: the bus clock and the command/data select pin, no strip on them */
+#define MLED_I2S_PIN_WR     GPIO_NUM_4
+#define MLED_I2S_PIN_DC     GPIO_NUM_5
+/* I2S engine: max. pixels of a strip, the DMA buffer holds the bit planes of
+ * all strips sized for RGBW (4 bytes, 32 bits of 4 slots per pixel),
+ * 8 strips: pixel_n * 128 bytes, 16 strips: pixel_n * 256 bytes, plus the reset code */
+#define MLED_I2S_PIXEL_N_MAX 300
+/* WS281x payload encoder, 1: copies prebuilt RMT symbols from a nibble LUT,
+ * 0: the IDF bytes encoder (bit by bit in the RMT ISR), INSTR_MLED_ENCODE compares them */
+#define MLED_WS281X_LUT     1
+/* FFT shader brightness levels, every pixel has an RGB ramp of this many levels
+ * baked at the shader init, heap: pixel_n * LIGHTS_FFT_LEVEL_N * 3 bytes per FFT zone */
+#define LIGHTS_FFT_LEVEL_N  32
+/* output stage: the shaders render 16 bit per channel, then a gamma LUT
+ * indexed by the top LIGHTS_GAMMA_LUT_BITS maps it to the 8 bit of the strip,
+ * the default gamma, config.json can override it */
+#define LIGHTS_GAMMA        2.2f
+#define LIGHTS_GAMMA_LUT_BITS 10
+/* 1: temporal dithering of the 8 bit output (the lost fraction shows up as
+ * the average of the frames), 0: rounding. A changed frame is dithered for one
+ * 256 frame cycle (~2.6s with the 10ms lights loop), then rounded and held:
+ * the strip data line toggles and the CPU clock stays up only during the cycle,
+ * a steady dither would cost the power save and radiate the strip data (EMI) forever */
+#define LIGHTS_DITHER       1
 
 /* used I2C peripheral number */
 #define I2C_PERIPH_NUM      I2C_NUM_0
@@ -30,45 +72,130 @@
 #define I2C_ADDRESS_CODEC   0x1A // from WM8960 datasheet
 
 /* used audio config */
+#define AUDIO_SAMPLE_RATE   44100 // the only SBC rate accepted from the source
 #define AUDIO_SAMPLE_BYTE_LEN sizeof(uint16_t)
 #define AUDIO_SAMPLE_BIT_LEN (AUDIO_SAMPLE_BYTE_LEN * 8)
 #define AUDIO_CHANNEL_N     2 // 2 -> left, right (stereo)
 #define I2S_SLOT_MODE       I2S_SLOT_MODE_STEREO
 
+/* task core placement policy,
+ * core 0 also runs the Bluetooth controller, Bluedroid, WiFi and lwIP
+ *  TASKS_PLACEMENT_CORE1: every application task and the HTTP server on core 1
+ *  TASKS_PLACEMENT_SPLIT: the analyzer (DSP) on core 0, the outputs (audio player, lights)
+ *   and the HTTP server on core 1, the server's priority (5) below the outputs (12),
+ *   so its handlers run only while the outputs wait and never compete with the DSP,
+ *   the web traffic itself still goes through lwIP and WiFi on core 0 */
+#define TASKS_PLACEMENT_CORE1 0
+#define TASKS_PLACEMENT_SPLIT 1
+#define TASKS_PLACEMENT TASKS_PLACEMENT_SPLIT
+
+#if TASKS_PLACEMENT == TASKS_PLACEMENT_SPLIT
+#define TASKS_CORE_AUDIO_PLAYER 1
+#define TASKS_CORE_DSP 0
+#define TASKS_CORE_LIGHTS 1
+#define TASKS_CORE_HTTP_SERVER 1
+#else
+#define TASKS_CORE_AUDIO_PLAYER 1
+#define TASKS_CORE_DSP 1
+#define TASKS_CORE_LIGHTS 1
+#define TASKS_CORE_HTTP_SERVER 1
+#endif
+
+#if (TASKS_PLACEMENT == TASKS_PLACEMENT_SPLIT) && (TASKS_CORE_HTTP_SERVER == TASKS_CORE_DSP)
+#error "the HTTP server must not share the core of the DSP"
+#endif
+
 /* used I2S peripheral number */
 #define I2S_PERIPH_NUM      I2S_NUM_0
-/* I2S DMA buffer number
- *  1: laggy, dropping sound
- *  increasing value getting faster I2S channel writing */
-#define I2S_DMA_BUF_N       6
-/* I2S frame size in one DMA buffer
- *  it should be the multiple of audio sample byte length */
-#define I2S_DMA_BUF_SIZE    (400 * AUDIO_SAMPLE_BYTE_LEN)
-
-/* the length of buffer between
- * Bluetooth stack and I2S DMA channel memory
- *  it should be the multiple of audio packet size
- *  audio packet size: sample size * channel number */
-#define AUDIO_BUF_LEN       (3200 * (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N))
-/*
- * the trigger level when started writing the buffered
- * audio packets to I2S DMA memory buffer
- * usually audio samples size in 1 Bluetooth packet
- *  - in windows: 640 (2560 bytes)
- *  - in android: 1024 (4096 bytes)
- *
- *               |   1. |   2. |   3. |   4. |   5. |   6.
- * --------------+------+------+------+------+------+------
- *  case windows |  640 | 1280 | 1920 | 2560 | 3200 | 3840
- *  case android | 1024 | 2048 | 3072 | 4096 | 5120 | 6144
- */
-#define AUDIO_BUF_TRIGGER_LEVEL (1000 * (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N))
-/* this number control how many data is send once for the I2S from the buffered audio data
- * too large value increase packet dropping but too small value not enough
- * while next audio data sent to I2S */
-#define AUDIO_BUF_RECEIVE_SIZE (480 * (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N))
-/* the number how many time sending data to I2S while blocking */
-#define AUDIO_BUF_MAX_FLUSH_N 30
+/* I2S DMA buffers and the buffer between Bluetooth stack and I2S DMA
+ * are sized by the buffering profile (audio_profile.c),
+ * selectable at runtime and stored in config.json,
+ * this one used when nothing stored */
+#define AUDIO_PROFILE_DEFAULT AUDIO_PROFILE_BALANCED
+
+/* look-ahead limiter on the played out audio
+ * the gain envelope is calculated once per block,
+ * the look-ahead (and added latency) is 2 blocks: 64 frames ~1.45ms */
+#define LIMITER_BLOCK_FRAMES 32
+/* gain applied before limiting, this makes the output louder on average */
+#define LIMITER_INPUT_GAIN_DB 4.0f
+/* output peaks never go above this level (0dB is the DAC full scale) */
+#define LIMITER_CEILING_DB (-0.3f)
+/* time needed to release ~63% of the gain reduction */
+#define LIMITER_RELEASE_MS 80
+
+/* audio concealment instead of clicks
+ * overflow: packet shortened with a crossfaded cut, length of the crossfade */
+#define CONCEAL_XFADE_FRAMES 32
+/* overflow: step of the low energy cut position search */
+#define CONCEAL_SEARCH_STEP (CONCEAL_XFADE_FRAMES / 2)
+/* underrun: the last played frames used to fade out the gap */
+#define CONCEAL_HISTORY_FRAMES 256
+/* underrun: length of the fade out, ~11.6ms */
+#define CONCEAL_FADE_FRAMES 512
+/* underrun: after the ringbuf became empty, wait for new data
+ * this percent of the I2S DMA play out time,
+ * before concealment written behind the remaining I2S DMA data */
+#define CONCEAL_UNDERRUN_WAIT_PERCENT 50
+
+
+/* A2DP delay reporting to the audio source (for lip-sync)
+ * output latency = ringbuf fill + I2S DMA buffers + limiter look-ahead + codec,
+ * group delay of the codec's DAC digital filter in us */
+#define A2DP_DELAY_CODEC_US 500
+/* the latency is averaged over packets, checked at every this many packets */
+#define A2DP_DELAY_CHECK_PACKET_N 50
+/* new delay reported only when it changed more than this */
+#define A2DP_DELAY_THRESHOLD_MS 15
+
+/* runtime profiler, sampled and pushed to the WebSocket clients periodically */
+#define PROFILER_PUSH_MS 1000
+/* loop duration histogram buckets: 1us, 2us, 4us ... 32ms and over */
+#define PROFILER_HIST_N 16
+/* the most tasks reported, must be at least the number of tasks in the system */
+#define PROFILER_TASK_MAX 32
+/* profiler statistic logged also to the serial after this many samples */
+#define PROFILER_LOG_N 60
+
+/* hot path instrumentation, 0: the INSTR_BEGIN / INSTR_END macros compile to nothing */
+#define INSTR_ENABLE 1
+/* duration histogram buckets: 1, 2, 4 ... 2^23 cycles (~35ms at 240MHz) and over */
+#define INSTR_HIST_N 24
+/* max text length of an instrumentation dump */
+#define INSTR_DUMP_SIZE 1024
+
+/* the queue vs task notification mailbox cost measured and logged once at startup,
+ * 0: not built in */
+#define TASKS_MAIL_BENCHMARK_ENABLE 0
+
+/* event trace ring, downloadable from the web server at /trace,
+ * 0: the trace_event calls compile to nothing */
+#define TRACE_ENABLE 1
+/* records in the ring (8 bytes each), must be power of 2 */
+#define TRACE_RECORD_N 1024
+
+/* dynamic frequency scaling (CONFIG_PM_ENABLE), the CPU runs on the max
+ * frequency only while audio streaming or lights animating, else on this,
+ * light sleep not used (Bluetooth Classic and WiFi AP keep the radio on) */
+#define PM_CPU_FREQ_MIN_MHZ 80
+
+/* audio input capture for offline replay (host/replay), started at /capture/start,
+ * downloaded at /capture, PCM kept while fits (~0.27s), then only the packet timing */
+#define CAPTURE_BUF_SIZE (48 * 1024)
+
+/* audio to light latency probe, an impulse (click) after silence is timed from
+ * tasks_audio_data through the DSP and lights loops to the end of the strip transmit,
+ * reported with the instrumentation dump, 0: the probe calls compile to nothing */
+#define LATENCY_ENABLE 1
+/* impulse: a sample at least this loud in a packet after a packet quieter than LATENCY_QUIET_LEVEL */
+#define LATENCY_IMPULSE_LEVEL 16384
+#define LATENCY_QUIET_LEVEL 256
+/* a probe not reaching the strip in this time dropped (e.g. no FFT zone) */
+#define LATENCY_TIMEOUT_US 500000
+/* latest finished probes kept for the percentiles */
+#define LATENCY_SAMPLE_N 128
+/* max text length of a latency dump */
+#define LATENCY_DUMP_SIZE 512
 
 
 #endif /* __APP_CONFIG_H__ */
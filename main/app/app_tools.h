@@ -78,7 +78,7 @@
     } while(0)
 
 #define PRINT_ARRAY_HEX(array, len) do {    \
-        for(uint8_t i = 0; i < len; i++)    \
+        for(size_t i = 0; i < len; i++)     \
         {                                   \
             printf(" %02X", array[i]);      \
         }                                   \
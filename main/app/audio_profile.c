@@ -0,0 +1,70 @@
+
+#include "string.h"
+
+#include "audio_profile.h"
+
+
+/* dma_buf_n:
+ *  1: laggy, dropping sound
+ *  increasing value getting faster I2S channel writing
+ * dma_buf_frames:
+ *  one DMA buffer max 4092 bytes, so max 1023 frames
+ * ring_frames:
+ *  it should be the multiple of audio packet size
+ * trigger_frames:
+ *  usually audio samples size in 1 Bluetooth packet
+ *   - in windows: 640 (2560 bytes)
+ *   - in android: 1024 (4096 bytes)
+ *
+ *                |   1. |   2. |   3. |   4. |   5. |   6.
+ *  --------------+------+------+------+------+------+------
+ *   case windows |  640 | 1280 | 1920 | 2560 | 3200 | 3840
+ *   case android | 1024 | 2048 | 3072 | 4096 | 5120 | 6144
+ *
+ * output latency ~ (trigger_frames + dma_buf_n * dma_buf_frames) / 44.1 [ms] */
+static const audio_profile profiles[AUDIO_PROFILE_MAX] = {
+    /* ~35ms, for live use (DJ booth), sensitive to radio interference */
+    [AUDIO_PROFILE_LOW_LATENCY] = {
+        .name = "low_latency",
+        .dma_buf_n = 4,
+        .dma_buf_frames = 256,
+        .ring_frames = 3072,
+        .trigger_frames = 512
+    },
+    /* ~130ms */
+    [AUDIO_PROFILE_BALANCED] = {
+        .name = "balanced",
+        .dma_buf_n = 6,
+        .dma_buf_frames = 800,
+        .ring_frames = 3200,
+        .trigger_frames = 1000
+    },
+    /* ~220ms, for background music, survives longer radio gaps */
+    [AUDIO_PROFILE_ROBUST] = {
+        .name = "robust",
+        .dma_buf_n = 8,
+        .dma_buf_frames = 800,
+        .ring_frames = 6400,
+        .trigger_frames = 3200
+    }
+};
+
+
+const audio_profile *audio_profile_get(audio_profile_id id)
+{
+    if(id >= AUDIO_PROFILE_MAX) id = AUDIO_PROFILE_DEFAULT;
+
+    return &profiles[id];
+}
+
+audio_profile_id audio_profile_find(const char *name)
+{
+    if(!name) return AUDIO_PROFILE_MAX;
+
+    for(uint8_t i = 0; i < AUDIO_PROFILE_MAX; i++)
+    {
+        if(!strcmp(profiles[i].name, name)) return i;
+    }
+
+    return AUDIO_PROFILE_MAX;
+}
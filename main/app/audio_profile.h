@@ -0,0 +1,37 @@
+/*
+ * Audio buffering profiles (latency vs robustness)
+ */
+
+#ifndef __APP_AUDIO_PROFILE_H__
+#define __APP_AUDIO_PROFILE_H__
+
+
+#include "stdint.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+typedef enum {
+    AUDIO_PROFILE_LOW_LATENCY,
+    AUDIO_PROFILE_BALANCED,
+    AUDIO_PROFILE_ROBUST,
+    AUDIO_PROFILE_MAX
+} audio_profile_id;
+
+/* every size is in frames (frame: sample size * channel number) */
+typedef struct {
+    const char *name; // used in config.json
+    uint8_t dma_buf_n; // I2S DMA buffer number
+    uint16_t dma_buf_frames; // frames in one I2S DMA buffer
+    uint16_t ring_frames; // buffer between Bluetooth stack and I2S DMA
+    uint16_t trigger_frames; // buffered level when play out starts
+} audio_profile;
+
+
+const audio_profile *audio_profile_get(audio_profile_id id);
+/* AUDIO_PROFILE_MAX if name unknown */
+audio_profile_id audio_profile_find(const char *name);
+
+
+#endif /* __APP_AUDIO_PROFILE_H__ */
@@ -0,0 +1,90 @@
+
+#include "stdlib.h"
+#include "string.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#include "app_tools.h"
+#include "capture.h"
+
+
+static const char *TAG = LOG_COLOR("36") "CAPTURE" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("36") "CAPTURE" LOG_COLOR_E;
+/* used for make thread safe the capture buffer (written by the Bluetooth stack),
+ * the writer never waits for it, only skips the packet */
+static SemaphoreHandle_t capture_semaphore = NULL;
+static uint8_t *buf = NULL; // semaphored with capture_semaphore
+static size_t buf_used = 0;
+static uint32_t record_n = 0;
+static int64_t start_time = 0;
+
+
+bool capture_start()
+{
+    if(!capture_semaphore)
+    {
+        capture_semaphore = xSemaphoreCreateMutex();
+        ERR_IF_NULL_RETURN_VAL(capture_semaphore, false);
+    }
+
+    xSemaphoreTake(capture_semaphore, portMAX_DELAY);
+    free(buf);
+    buf = (uint8_t*)malloc(CAPTURE_BUF_SIZE);
+    /* magic and record_n written at the end */
+    buf_used = 8;
+    record_n = 0;
+    start_time = esp_timer_get_time();
+    xSemaphoreGive(capture_semaphore);
+    ERR_IF_NULL_RETURN_VAL(buf, false);
+    ESP_LOGI(TAG, "capture started into %d bytes", CAPTURE_BUF_SIZE);
+    return true;
+}
+
+void capture_packet(const uint8_t *data, size_t len)
+{
+    if(!buf || (pdTRUE != xSemaphoreTake(capture_semaphore, 0))) return;
+
+    capture_record record = {
+        .time_us = (uint32_t)(esp_timer_get_time() - start_time),
+        .len = len,
+        .stored_len = len
+    };
+
+    if(buf && ((buf_used + sizeof(capture_record)) <= CAPTURE_BUF_SIZE))
+    {
+        if((buf_used + sizeof(capture_record) + len) > CAPTURE_BUF_SIZE) record.stored_len = 0;
+
+        memcpy(&buf[buf_used], &record, sizeof(capture_record));
+        buf_used += sizeof(capture_record);
+        memcpy(&buf[buf_used], data, record.stored_len);
+        buf_used += record.stored_len;
+        record_n++;
+    }
+
+    xSemaphoreGive(capture_semaphore);
+}
+
+uint8_t *capture_take(size_t *len)
+{
+    if(!capture_semaphore) return NULL;
+
+    xSemaphoreTake(capture_semaphore, portMAX_DELAY);
+    uint8_t *ret = buf;
+    buf = NULL;
+    xSemaphoreGive(capture_semaphore);
+
+    if(!ret)
+    {
+        ESP_LOGE(TAGE, "nothing captured");
+        return NULL;
+    }
+
+    uint32_t magic = CAPTURE_MAGIC;
+    memcpy(ret, &magic, 4);
+    memcpy(&ret[4], &record_n, 4);
+    *len = buf_used;
+    ESP_LOGI(TAG, "capture stopped, %ld packets, %d bytes", record_n, buf_used);
+    return ret;
+}
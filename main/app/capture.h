@@ -0,0 +1,40 @@
+/*
+ * Audio input capture (raw PCM packets with arrival time) for offline replay
+ */
+
+#ifndef __APP_CAPTURE_H__
+#define __APP_CAPTURE_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+/* "CAP1" little endian, at the start of the capture */
+#define CAPTURE_MAGIC 0x31504143
+
+
+/* capture layout (little endian):
+ *  magic (uint32) + record_n (uint32)
+ *  + record_n * (capture_record + stored_len bytes of PCM) */
+typedef struct {
+    uint32_t time_us; // arrival time since capture_start
+    uint16_t len; // packet length
+    uint16_t stored_len; // len, or 0 after the buffer filled up (only timing kept)
+} capture_record;
+
+
+/* (re)start capturing into a new CAPTURE_BUF_SIZE buffer,
+ * false if no memory */
+bool capture_start();
+/* called with every incoming audio packet, does nothing while not capturing */
+void capture_packet(const uint8_t *data, size_t len);
+/* stop capturing and take the capture buffer, it has to be freed,
+ * NULL if not captured */
+uint8_t *capture_take(size_t *len);
+
+
+#endif /* __APP_CAPTURE_H__ */
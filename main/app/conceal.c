@@ -0,0 +1,174 @@
+
+#include "stdlib.h"
+#include "string.h"
+
+#include "app_tools.h"
+#include "conceal.h"
+
+
+/* last played frames, circular buffer of interleaved stereo frames */
+static int16_t history[CONCEAL_HISTORY_FRAMES * AUDIO_CHANNEL_N] = {0};
+/* history_i points to the oldest frame */
+static size_t history_i = 0;
+/* after a concealed gap the next played frames need fade in,
+ * fade_in_i counts the already played frames, the first fade_in_skip are silence */
+static bool faded_out = false;
+static size_t fade_in_i = 0;
+static size_t fade_in_skip = 0;
+
+
+static uint32_t conceal_energy(const int16_t *frames, size_t frame_n);
+
+
+void conceal_reset()
+{
+    memset(history, 0, sizeof(history));
+    history_i = 0;
+    faded_out = false;
+    fade_in_i = 0;
+    fade_in_skip = 0;
+}
+
+bool conceal_trim(const int16_t *frames, size_t frame_n, size_t cut_n, conceal_trim_res *res)
+{
+    if(!cut_n || (frame_n < (cut_n + CONCEAL_XFADE_FRAMES))) return false;
+
+    /* the crossfade joins the frames before and after the cut,
+     * search the place where both sides are the most quiet */
+    size_t pos_max = frame_n - cut_n - CONCEAL_XFADE_FRAMES;
+    size_t pos_best = 0;
+    uint32_t energy_best = UINT32_MAX;
+    uint32_t energy;
+
+    for(size_t pos = 0; pos <= pos_max; pos += CONCEAL_SEARCH_STEP)
+    {
+        energy = conceal_energy(&frames[pos * AUDIO_CHANNEL_N], CONCEAL_XFADE_FRAMES);
+        energy += conceal_energy(&frames[(pos + cut_n) * AUDIO_CHANNEL_N], CONCEAL_XFADE_FRAMES);
+
+        if(energy < energy_best)
+        {
+            energy_best = energy;
+            pos_best = pos;
+        }
+    }
+
+    const int16_t *fade_out = &frames[pos_best * AUDIO_CHANNEL_N];
+    const int16_t *fade_in = &frames[(pos_best + cut_n) * AUDIO_CHANNEL_N];
+    int16_t *dest = res->xfade;
+    int32_t w_in;
+
+    for(size_t i = 0; i < CONCEAL_XFADE_FRAMES; i++)
+    {
+        /* weight range: [1..CONCEAL_XFADE_FRAMES] / (CONCEAL_XFADE_FRAMES + 1) */
+        w_in = i + 1;
+
+        for(uint8_t ch = 0; ch < AUDIO_CHANNEL_N; ch++)
+        {
+            *dest++ = ((*fade_out++ * (CONCEAL_XFADE_FRAMES + 1 - w_in)) + (*fade_in++ * w_in)) / (CONCEAL_XFADE_FRAMES + 1);
+        }
+    }
+
+    res->head_n = pos_best;
+    res->tail_pos = pos_best + cut_n + CONCEAL_XFADE_FRAMES;
+    res->tail_n = frame_n - res->tail_pos;
+    return true;
+}
+
+void conceal_fill(int16_t *out, size_t silent_n)
+{
+    /* play back the history in reverse direction from the newest frame,
+     * so the gap starts without a jump in the waveform,
+     * at the oldest frame turn back (ping-pong) if history is shorter */
+    size_t k, hist_pos;
+    int32_t gain;
+    const int16_t *src;
+
+    for(size_t i = 0; i < CONCEAL_FADE_FRAMES; i++)
+    {
+        k = i % (CONCEAL_HISTORY_FRAMES * 2);
+
+        /* hist_pos: 0 is the oldest, CONCEAL_HISTORY_FRAMES - 1 is the newest */
+        if(k < CONCEAL_HISTORY_FRAMES) hist_pos = CONCEAL_HISTORY_FRAMES - 1 - k;
+        else hist_pos = k - CONCEAL_HISTORY_FRAMES;
+
+        hist_pos += history_i;
+
+        if(CONCEAL_HISTORY_FRAMES <= hist_pos) hist_pos -= CONCEAL_HISTORY_FRAMES;
+
+        src = &history[hist_pos * AUDIO_CHANNEL_N];
+        gain = CONCEAL_FADE_FRAMES - i;
+
+        for(uint8_t ch = 0; ch < AUDIO_CHANNEL_N; ch++)
+        {
+            *out++ = (*src++ * gain) / CONCEAL_FADE_FRAMES;
+        }
+    }
+
+    faded_out = true;
+    fade_in_i = 0;
+    fade_in_skip = silent_n;
+}
+
+void conceal_played(int16_t *frames, size_t frame_n)
+{
+    if(faded_out)
+    {
+        int16_t *p = frames;
+        size_t fade_in_end = fade_in_skip + CONCEAL_XFADE_FRAMES;
+        int32_t w_in;
+
+        for(size_t i = 0; (i < frame_n) && (fade_in_i < fade_in_end); i++, fade_in_i++)
+        {
+            if(fade_in_i < fade_in_skip)
+            {
+                p += AUDIO_CHANNEL_N;
+                continue;
+            }
+
+            w_in = fade_in_i - fade_in_skip + 1;
+
+            for(uint8_t ch = 0; ch < AUDIO_CHANNEL_N; ch++, p++)
+            {
+                *p = (*p * w_in) / (CONCEAL_XFADE_FRAMES + 1);
+            }
+        }
+
+        if(fade_in_end <= fade_in_i) faded_out = false;
+    }
+
+    /* only the block end is needed to the history */
+    if(frame_n > CONCEAL_HISTORY_FRAMES)
+    {
+        frames += (frame_n - CONCEAL_HISTORY_FRAMES) * AUDIO_CHANNEL_N;
+        frame_n = CONCEAL_HISTORY_FRAMES;
+    }
+
+    size_t part_n;
+
+    while(frame_n)
+    {
+        part_n = CONCEAL_HISTORY_FRAMES - history_i;
+
+        if(part_n > frame_n) part_n = frame_n;
+
+        memcpy(&history[history_i * AUDIO_CHANNEL_N], frames, part_n * CONCEAL_FRAME_SIZE);
+        frames += part_n * AUDIO_CHANNEL_N;
+        frame_n -= part_n;
+        history_i += part_n;
+
+        if(CONCEAL_HISTORY_FRAMES <= history_i) history_i = 0;
+    }
+}
+
+static uint32_t conceal_energy(const int16_t *frames, size_t frame_n)
+{
+    /* sum of absolute values is enough to compare loudness */
+    uint32_t sum = 0;
+
+    for(size_t i = 0; i < (frame_n * AUDIO_CHANNEL_N); i++)
+    {
+        sum += abs(frames[i]);
+    }
+
+    return sum;
+}
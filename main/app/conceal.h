@@ -0,0 +1,42 @@
+/*
+ * Audio concealment of ringbuf overflow and underrun
+ */
+
+#ifndef __APP_CONCEAL_H__
+#define __APP_CONCEAL_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+#define CONCEAL_FRAME_SIZE (AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N)
+
+
+typedef struct {
+    size_t head_n; // frames kept from the packet start
+    size_t tail_pos; // first frame kept after the crossfade
+    size_t tail_n; // frames kept from tail_pos to the packet end
+    int16_t xfade[CONCEAL_XFADE_FRAMES * AUDIO_CHANNEL_N]; // joins head and tail
+} conceal_trim_res;
+
+
+void conceal_reset();
+/* overflow: shorten the packet by cut_n frames with a crossfaded cut
+ * at the lowest energy point, false if the packet too short for that */
+bool conceal_trim(const int16_t *frames, size_t frame_n, size_t cut_n, conceal_trim_res *res);
+/* underrun: fade out with the last played frames,
+ * out has to fit CONCEAL_FADE_FRAMES frames,
+ * silent_n: the next played frames are still silence (an emptied delay line),
+ * the fade in starts after them */
+void conceal_fill(int16_t *out, size_t silent_n);
+/* must be called with every played out block, in place:
+ *  - fade in after a concealed gap
+ *  - save the block end for later concealment */
+void conceal_played(int16_t *frames, size_t frame_n);
+
+
+#endif /* __APP_CONCEAL_H__ */
@@ -5,6 +5,7 @@
 
 #include "app_tools.h"
 #include "dsp.h"
+#include "instr.h"
 
 
 static const char *TAG = LOG_COLOR("37") "DSP";
@@ -62,7 +63,9 @@ void dsp_fft_buf_del()
 
 void dsp_fft_do()
 {
+    INSTR_BEGIN(INSTR_DSP_FFT);
     dsp_fft(fft_work_r, fft_work_l);
+    INSTR_END(INSTR_DSP_FFT);
 }
 
 void dsp_fft_finalize()
@@ -149,6 +152,9 @@ float *dsp_fft_get_res(bool is_right)
 
 void dsp_new_data(const uint8_t *data, size_t size)
 {
+    /* packets may come before the audio player prepared the stream */
+    if(!ringbuf) return;
+
     for(size_t i = 0; i < size; i++)
     {
         ringbuf[ringbuf_i++] = *data++;
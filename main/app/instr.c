@@ -0,0 +1,93 @@
+
+#include "stdio.h"
+#include "string.h"
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+
+#include "instr.h"
+
+
+typedef struct {
+    uint32_t n;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[INSTR_HIST_N]; // bucket i: [2^i, 2^(i+1)), first and last are open
+} instr_stat;
+
+
+static const char *instr_names[INSTR_MAX] = {
+    [INSTR_DSP_FFT] = "dsp_fft",
+    [INSTR_LIGHTS_MAIN] = "lights_main",
+    [INSTR_MLED_ENCODE] = "mled_encode",
+    [INSTR_AUDIO_DATA] = "tasks_audio_data"
+};
+/* used for make thread safe the statistic (written by tasks and ISR) */
+static portMUX_TYPE stat_lock = portMUX_INITIALIZER_UNLOCKED;
+static instr_stat stats[INSTR_MAX] = {0}; // locked with stat_lock
+
+
+void IRAM_ATTR instr_record(instr_id id, uint32_t duration)
+{
+    instr_stat *stat = &stats[id];
+    uint8_t bucket = duration ? (31 - __builtin_clz(duration)) : 0;
+
+    if(bucket >= INSTR_HIST_N) bucket = INSTR_HIST_N - 1;
+
+    portENTER_CRITICAL_SAFE(&stat_lock);
+    stat->n++;
+    stat->sum += duration;
+    stat->hist[bucket]++;
+
+    if(duration > stat->max) stat->max = duration;
+
+    portEXIT_CRITICAL_SAFE(&stat_lock);
+}
+
+size_t instr_dump(char *out, size_t size, bool reset)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    const char *unit = "ns";
+#else
+    const char *unit = "cycles";
+#endif
+    size_t len = 0;
+
+    if(!size) return 0;
+
+    out[0] = '\0';
+
+#if INSTR_ENABLE
+    instr_stat copy[INSTR_MAX];
+    portENTER_CRITICAL_SAFE(&stat_lock);
+    memcpy(copy, stats, sizeof(stats));
+
+    if(reset) memset(stats, 0, sizeof(stats));
+
+    portEXIT_CRITICAL_SAFE(&stat_lock);
+
+    /* snprintf returns the wanted length, so stop at the first cut */
+    len = snprintf(out, size, "instrumentation [%s], histogram: bucket (log2): count\n", unit);
+
+    for(uint8_t id = 0; (id < INSTR_MAX) && (len < size); id++)
+    {
+        instr_stat *stat = &copy[id];
+        uint32_t avg = stat->n ? (stat->sum / stat->n) : 0;
+        len += snprintf(&out[len], size - len, "%s: n %lu, avg %lu, max %lu\n ",
+            instr_names[id], (unsigned long)stat->n, (unsigned long)avg, (unsigned long)stat->max);
+
+        for(uint8_t i = 0; (i < INSTR_HIST_N) && (len < size); i++)
+        {
+            if(stat->hist[i]) len += snprintf(&out[len], size - len, " %d: %lu", i, (unsigned long)stat->hist[i]);
+        }
+
+        if(len < size) len += snprintf(&out[len], size - len, "\n");
+    }
+#else
+    (void)reset;
+    (void)unit;
+    len = snprintf(out, size, "instrumentation disabled (INSTR_ENABLE)\n");
+#endif
+
+    return (len < size) ? len : (size - 1);
+}
@@ -0,0 +1,62 @@
+/*
+ * Hot path instrumentation (cycle count histograms)
+ */
+
+#ifndef __APP_INSTR_H__
+#define __APP_INSTR_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "sdkconfig.h"
+#include "app_config.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include "time.h"
+#else
+#include "esp_cpu.h"
+#endif
+
+
+typedef enum {
+    INSTR_DSP_FFT,
+    INSTR_LIGHTS_MAIN,
+    INSTR_MLED_ENCODE,
+    INSTR_AUDIO_DATA,
+    INSTR_MAX
+} instr_id;
+
+
+#if INSTR_ENABLE
+/* measure the code between INSTR_BEGIN and INSTR_END with the same id
+ * in the same scope, disabled they compile to nothing */
+#define INSTR_BEGIN(id) uint32_t instr_begin_##id = instr_now()
+#define INSTR_END(id) instr_record(id, instr_now() - instr_begin_##id)
+#else
+#define INSTR_BEGIN(id) do {} while(0)
+#define INSTR_END(id) do {} while(0)
+#endif
+
+
+/* target: CPU cycles, host: ns, both wraps at 32 bit */
+static inline uint32_t instr_now()
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+#else
+    return esp_cpu_get_cycle_count();
+#endif
+}
+
+/* callable from ISR too */
+void instr_record(instr_id id, uint32_t duration);
+/* write the statistic as text table into out (zero ended, cut to size),
+ * reset: clear the statistic after, returns the text length */
+size_t instr_dump(char *out, size_t size, bool reset);
+
+
+#endif /* __APP_INSTR_H__ */
@@ -0,0 +1,167 @@
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#include "latency.h"
+
+
+static const char *stage_names[LATENCY_STAGE_MAX] = {
+    [LATENCY_STAGE_DSP] = "dsp",
+    [LATENCY_STAGE_FRAME] = "frame",
+    [LATENCY_STAGE_TX] = "tx"
+};
+#if LATENCY_ENABLE
+/* used for make thread safe the probe (stages reached by tasks and ISR) */
+static portMUX_TYPE probe_lock = portMUX_INITIALIZER_UNLOCKED;
+/* one probe in flight at once, LATENCY_STAGE_MAX: no probe */
+static latency_stage waiting_stage = LATENCY_STAGE_MAX;
+static int64_t probe_start = 0;
+static uint32_t probe_us[LATENCY_STAGE_MAX] = {0};
+/* a new probe needs silence before the impulse */
+static bool armed = false;
+/* ring of the finished probes, stage times from the impulse in us */
+static uint32_t samples[LATENCY_SAMPLE_N][LATENCY_STAGE_MAX] = {0};
+static uint32_t sample_n = 0; // finished probes since reset
+static uint32_t timeout_n = 0;
+#endif
+
+
+#if LATENCY_ENABLE
+static bool latency_timed_out(int64_t now);
+static int latency_cmp(const void *a, const void *b);
+#endif
+
+
+#if LATENCY_ENABLE
+void latency_audio_in(const uint8_t *data, size_t size)
+{
+    int64_t now = esp_timer_get_time();
+    bool idle;
+
+    portENTER_CRITICAL_SAFE(&probe_lock);
+    idle = (waiting_stage == LATENCY_STAGE_MAX) || latency_timed_out(now);
+    portEXIT_CRITICAL_SAFE(&probe_lock);
+
+    if(!idle) return;
+
+    const int16_t *samples_in = (const int16_t*)data;
+    int32_t peak = 0;
+
+    for(size_t i = 0; i < (size / AUDIO_SAMPLE_BYTE_LEN); i++)
+    {
+        int32_t value = abs(samples_in[i]);
+
+        if(value > peak) peak = value;
+    }
+
+    if(peak < LATENCY_QUIET_LEVEL) armed = true;
+    else if(armed && (peak >= LATENCY_IMPULSE_LEVEL))
+    {
+        armed = false;
+        portENTER_CRITICAL_SAFE(&probe_lock);
+        probe_start = now;
+        waiting_stage = LATENCY_STAGE_DSP;
+        portEXIT_CRITICAL_SAFE(&probe_lock);
+    }
+}
+
+void IRAM_ATTR latency_reached(latency_stage stage)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_SAFE(&probe_lock);
+
+    if((waiting_stage == stage) && !latency_timed_out(now))
+    {
+        probe_us[stage] = now - probe_start;
+
+        if(LATENCY_STAGE_MAX == ++waiting_stage)
+        {
+            memcpy(samples[sample_n % LATENCY_SAMPLE_N], probe_us, sizeof(probe_us));
+            sample_n++;
+        }
+    }
+
+    portEXIT_CRITICAL_SAFE(&probe_lock);
+}
+#endif
+
+size_t latency_dump(char *out, size_t size, bool reset)
+{
+    size_t len = 0;
+
+    if(!size) return 0;
+
+    out[0] = '\0';
+
+#if LATENCY_ENABLE
+    /* the sorting is too long for a critical section, copy first */
+    static uint32_t copy[LATENCY_SAMPLE_N][LATENCY_STAGE_MAX];
+    uint32_t stage_us[LATENCY_SAMPLE_N];
+    uint32_t copy_sample_n, copy_timeout_n;
+    portENTER_CRITICAL_SAFE(&probe_lock);
+    memcpy(copy, samples, sizeof(samples));
+    copy_sample_n = sample_n;
+    copy_timeout_n = timeout_n;
+
+    if(reset)
+    {
+        sample_n = 0;
+        timeout_n = 0;
+    }
+
+    portEXIT_CRITICAL_SAFE(&probe_lock);
+
+    uint32_t n = (copy_sample_n < LATENCY_SAMPLE_N) ? copy_sample_n : LATENCY_SAMPLE_N;
+    len = snprintf(out, size, "latency [us] from tasks_audio_data, probes: %lu (latest %lu kept), timeouts: %lu\n",
+        (unsigned long)copy_sample_n, (unsigned long)n, (unsigned long)copy_timeout_n);
+
+    for(uint8_t stage = 0; (stage < LATENCY_STAGE_MAX) && (len < size) && n; stage++)
+    {
+        uint64_t sum = 0;
+
+        for(uint32_t i = 0; i < n; i++)
+        {
+            stage_us[i] = copy[i][stage];
+            sum += stage_us[i];
+        }
+
+        qsort(stage_us, n, sizeof(stage_us[0]), latency_cmp);
+        /* nearest rank: the smallest value not less than 99% of the values */
+        uint32_t p99_i = ((n * 99) + 99) / 100 - 1;
+        len += snprintf(&out[len], size - len, "%s: min %lu, avg %lu, p99 %lu, max %lu\n", stage_names[stage],
+            (unsigned long)stage_us[0], (unsigned long)(sum / n), (unsigned long)stage_us[p99_i], (unsigned long)stage_us[n - 1]);
+    }
+#else
+    (void)reset;
+    (void)stage_names;
+    len = snprintf(out, size, "latency probe disabled (LATENCY_ENABLE)\n");
+#endif
+
+    return (len < size) ? len : (size - 1);
+}
+
+#if LATENCY_ENABLE
+/* must be called in probe_lock, a probe lost on the way
+ * (e.g. lights not animated, stream stopped) frees the probe */
+static bool IRAM_ATTR latency_timed_out(int64_t now)
+{
+    if((waiting_stage == LATENCY_STAGE_MAX) || ((now - probe_start) < LATENCY_TIMEOUT_US)) return false;
+
+    waiting_stage = LATENCY_STAGE_MAX;
+    timeout_n++;
+    return true;
+}
+
+static int latency_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Audio to light latency probe
+ */
+
+#ifndef __APP_LATENCY_H__
+#define __APP_LATENCY_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+/* a probe starts with an impulse at tasks_audio_data,
+ * then it passes the stages in this order */
+typedef enum {
+    LATENCY_STAGE_DSP, // FFT result containing the impulse finalized
+    LATENCY_STAGE_FRAME, // first LED frame rendered from it left mled_update
+    LATENCY_STAGE_TX, // the strip transmit ended (RMT done)
+    LATENCY_STAGE_MAX
+} latency_stage;
+
+
+#if LATENCY_ENABLE
+/* looks for an impulse after silence in the incoming audio packet */
+void latency_audio_in(const uint8_t *data, size_t size);
+/* callable from ISR too */
+void latency_reached(latency_stage stage);
+#else
+#define latency_audio_in(data, size) do {} while(0)
+#define latency_reached(stage) do {} while(0)
+#endif
+/* write min / avg / p99 / max of the latest probes as text table into out
+ * (zero ended, cut to size), reset: clear the statistic after, returns the text length */
+size_t latency_dump(char *out, size_t size, bool reset);
+
+
+#endif /* __APP_LATENCY_H__ */
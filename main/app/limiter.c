@@ -0,0 +1,140 @@
+
+#include "math.h"
+#include "string.h"
+
+#include "app_tools.h"
+#include "limiter.h"
+
+
+static const char *TAG = LOG_COLOR("37") "LIMIT";
+/* delay line, contains interleaved stereo frames */
+static int16_t delay_buf[LIMITER_DELAY_FRAMES * AUDIO_CHANNEL_N] = {0};
+/* delay_i points to the oldest frame, which goes out next
+ * and its place is taken by the incoming frame */
+static size_t delay_i = 0;
+/* peak of each half of the delay line, known after the half filled up */
+static float block_peak[2] = {0};
+static float fill_peak = 0;
+/* gain envelope, linear ramp inside one block */
+static float gain_cur = 1.0f;
+static float gain_step = 0;
+static float gain_end = 1.0f;
+/* values calculated from app_config.h settings */
+static float input_gain = 1.0f;
+static float ceiling = INT16_MAX;
+static float release_coef = 1.0f;
+/* metering, written only by the player task, read by anybody */
+static volatile float gain_min = 1.0f;
+
+
+static float limiter_block_gain(float peak);
+static void limiter_next_block();
+
+
+void limiter_init()
+{
+    input_gain = powf(10.0f, LIMITER_INPUT_GAIN_DB / 20.0f);
+    ceiling = (float)INT16_MAX * powf(10.0f, LIMITER_CEILING_DB / 20.0f);
+    /* one pole release, stepped once per block */
+    float block_ms = (LIMITER_BLOCK_FRAMES * 1000.0f) / (float)AUDIO_SAMPLE_RATE;
+    release_coef = 1.0f - expf(-block_ms / LIMITER_RELEASE_MS);
+    limiter_reset();
+    ESP_LOGI(TAG, "init OK, input gain: %.2f, ceiling: %.0f, release coef: %.4f", input_gain, ceiling, release_coef);
+}
+
+void limiter_reset()
+{
+    memset(delay_buf, 0, sizeof(delay_buf));
+    delay_i = 0;
+    block_peak[0] = 0;
+    block_peak[1] = 0;
+    fill_peak = 0;
+    gain_cur = 1.0f;
+    gain_step = 0;
+    gain_end = 1.0f;
+}
+
+void limiter_process(int16_t *frames, size_t frame_n)
+{
+    int16_t *delayed;
+    float in_l, in_r, out_l, out_r;
+    float peak;
+    float gain;
+
+    while(frame_n--)
+    {
+        if(!(delay_i % LIMITER_BLOCK_FRAMES)) limiter_next_block();
+
+        delayed = &delay_buf[delay_i * AUDIO_CHANNEL_N];
+        in_l = frames[0];
+        in_r = frames[1];
+        /* delayed frame goes out with the envelope gain */
+        gain = input_gain * gain_cur;
+        out_l = delayed[0] * gain;
+        out_r = delayed[1] * gain;
+        gain_cur += gain_step;
+        /* envelope keep the peaks under the ceiling,
+         * clamping only guards the float rounding */
+        if(out_l > INT16_MAX) out_l = INT16_MAX;
+        else if(out_l < INT16_MIN) out_l = INT16_MIN;
+        if(out_r > INT16_MAX) out_r = INT16_MAX;
+        else if(out_r < INT16_MIN) out_r = INT16_MIN;
+
+        frames[0] = lrintf(out_l);
+        frames[1] = lrintf(out_r);
+        delayed[0] = in_l;
+        delayed[1] = in_r;
+
+        peak = fmaxf(fabsf(in_l), fabsf(in_r)) * input_gain;
+
+        if(peak > fill_peak) fill_peak = peak;
+
+        frames += AUDIO_CHANNEL_N;
+
+        if(LIMITER_DELAY_FRAMES <= ++delay_i) delay_i = 0;
+    }
+}
+
+void limiter_drain(int16_t *frames)
+{
+    memset(frames, 0, LIMITER_DELAY_FRAMES * AUDIO_CHANNEL_N * sizeof(int16_t));
+    limiter_process(frames, LIMITER_DELAY_FRAMES);
+}
+
+void limiter_get_reduction(float *cur_db, float *max_db)
+{
+    float min = gain_min;
+    gain_min = 1.0f;
+    *cur_db = -20.0f * log10f(gain_cur);
+    *max_db = -20.0f * log10f(min);
+}
+
+static float limiter_block_gain(float peak)
+{
+    if(peak > ceiling) return ceiling / peak;
+    else return 1.0f;
+}
+
+/* called at block boundary, before the first frame of the block
+ *
+ *  delay_buf: | half 0 | half 1 |
+ *  the half at delay_i goes out now (its peak known since last boundary),
+ *  the other half just filled up, so its peak becomes known now */
+static void limiter_next_block()
+{
+    size_t out_half = delay_i / LIMITER_BLOCK_FRAMES;
+    block_peak[out_half ^ 1] = fill_peak;
+    fill_peak = 0;
+
+    /* the ramp arrived to the previous block end gain,
+     * set it exactly to avoid accumulating float rounding */
+    gain_cur = gain_end;
+    /* gain_cur already safe for the outgoing block,
+     * the block end gain has to be safe for both blocks */
+    gain_end = gain_cur + ((1.0f - gain_cur) * release_coef);
+    gain_end = fminf(gain_end, limiter_block_gain(block_peak[out_half]));
+    gain_end = fminf(gain_end, limiter_block_gain(block_peak[out_half ^ 1]));
+    gain_step = (gain_end - gain_cur) / (float)LIMITER_BLOCK_FRAMES;
+
+    if(gain_end < gain_min) gain_min = gain_end;
+}
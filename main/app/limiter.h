@@ -0,0 +1,32 @@
+/*
+ * Look-ahead peak limiter for the playback path
+ */
+
+#ifndef __APP_LIMITER_H__
+#define __APP_LIMITER_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+/* delay line holds the block under output and the next full block,
+ * so the gain envelope always knows the peak of the next block */
+#define LIMITER_DELAY_FRAMES (LIMITER_BLOCK_FRAMES * 2)
+
+
+void limiter_init();
+void limiter_reset();
+/* frames: interleaved stereo samples, processed in place */
+void limiter_process(int16_t *frames, size_t frame_n);
+/* silence pushed through: the LIMITER_DELAY_FRAMES frames still in the delay line
+ * written to frames (the stream end or before a gap), the delay line empty after */
+void limiter_drain(int16_t *frames);
+/* gain reduction in dB, current value and the largest one since the last call */
+void limiter_get_reduction(float *cur_db, float *max_db);
+
+
+#endif /* __APP_LIMITER_H__ */
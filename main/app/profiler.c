@@ -0,0 +1,240 @@
+
+#include "stdlib.h"
+#include "string.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+
+#include "app_tools.h"
+#include "profiler.h"
+#include "tasks.h"
+#include "ach.h"
+
+
+typedef struct {
+    uint32_t miss_n;
+    uint32_t jitter_max; // max deviation of the loop period [us]
+    uint16_t hist[PROFILER_HIST_N]; // loop work duration, log2 buckets [us]
+    int64_t start_prev;
+} profiler_loop_stat;
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t run_time;
+} profiler_task_prev;
+
+
+static const char *TAG = LOG_COLOR("36") "PROF" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("36") "PROF" LOG_COLOR_E;
+/* used for make thread safe the loop statistic (written by the loop tasks) */
+static portMUX_TYPE loop_lock = portMUX_INITIALIZER_UNLOCKED;
+static profiler_loop_stat loops[PROFILER_LOOP_MAX] = {0}; // locked with loop_lock
+/* nominal loop periods [us] */
+static const uint32_t loop_period[PROFILER_LOOP_MAX] = {
+    [PROFILER_LOOP_DSP] = pdTICKS_TO_MS(TASKS_DSP_MIN_TIME) * 1000,
+    [PROFILER_LOOP_LIGHTS] = pdTICKS_TO_MS(TASKS_LIGHTS_MIN_TIME) * 1000
+};
+/* task run times at the previous sample, only used by profiler_sample */
+static profiler_task_prev tasks_prev[PROFILER_TASK_MAX] = {0};
+static uint32_t total_prev = 0;
+static uint32_t sample_cnt = 0;
+
+
+static uint8_t *profiler_put(uint8_t *p, const void *src, size_t n);
+static uint32_t profiler_task_delta(TaskHandle_t handle, uint32_t run_time, profiler_task_prev *prev, uint8_t *prev_n);
+
+
+void profiler_loop(profiler_loop_id id, int64_t start_us, int64_t end_us, bool missed)
+{
+    profiler_loop_stat *loop = &loops[id];
+    uint32_t duration = end_us - start_us;
+    /* bucket i: [2^i, 2^(i+1)) us, first and last are open */
+    uint8_t bucket = duration ? (31 - __builtin_clz(duration)) : 0;
+
+    if(bucket >= PROFILER_HIST_N) bucket = PROFILER_HIST_N - 1;
+
+    taskENTER_CRITICAL(&loop_lock);
+
+    if(loop->hist[bucket] < UINT16_MAX) loop->hist[bucket]++;
+
+    if(missed) loop->miss_n++;
+
+    if(loop->start_prev)
+    {
+        uint32_t jitter = llabs((start_us - loop->start_prev) - loop_period[id]);
+
+        if(jitter > loop->jitter_max) loop->jitter_max = jitter;
+    }
+
+    loop->start_prev = start_us;
+    taskEXIT_CRITICAL(&loop_lock);
+}
+
+void profiler_loop_idle(profiler_loop_id id)
+{
+    taskENTER_CRITICAL(&loop_lock);
+    loops[id].start_prev = 0;
+    taskEXIT_CRITICAL(&loop_lock);
+}
+
+/* frame layout (little endian):
+ *  head_len bytes (free for the caller)
+ *  heap free (uint32) + heap min free (uint32)
+ *  core_n (uint8) + core_n * load [%] (uint8)
+ *  loop_n (uint8) + loop_n * (miss_n (uint32) + jitter max [us] (uint32) + PROFILER_HIST_N * count (uint16))
+ *  I2S refill: refill_n (uint32) + latency avg [us] (uint32) + latency max [us] (uint32) + slack min [us] (int32)
+ *  task_n (uint8) + task_n * (CPU share [1/10 % of one core] (uint16) + stack min free [bytes] (uint32) + core (uint8) + zero ended name) */
+uint8_t *profiler_sample(size_t head_len, size_t *len)
+{
+    size_t buf_len = head_len + 4 + 4
+        + 1 + portNUM_PROCESSORS
+        + 1 + PROFILER_LOOP_MAX * (4 + 4 + PROFILER_HIST_N * 2)
+        + 4 + 4 + 4 + 4
+        + 1 + PROFILER_TASK_MAX * (2 + 4 + 1 + configMAX_TASK_NAME_LEN);
+    uint8_t *buf = (uint8_t*)calloc(1, buf_len);
+    ERR_IF_NULL_RETURN_VAL(buf, NULL);
+    TaskStatus_t *status = (TaskStatus_t*)malloc(PROFILER_TASK_MAX * sizeof(TaskStatus_t));
+
+    if(!status)
+    {
+        free(buf);
+        ERR_IF_NULL_RETURN_VAL(status, NULL);
+    }
+
+    uint32_t total = 0;
+    UBaseType_t task_n = uxTaskGetSystemState(status, PROFILER_TASK_MAX, &total);
+
+    if(!task_n) ESP_LOGE(TAGE, "more tasks than PROFILER_TASK_MAX: %d", uxTaskGetNumberOfTasks());
+
+    uint32_t elapsed = total - total_prev;
+    total_prev = total;
+    profiler_task_prev prev[PROFILER_TASK_MAX];
+    uint8_t prev_n = 0;
+    uint8_t *p = buf + head_len;
+    uint32_t u32;
+    uint16_t u16;
+
+    u32 = esp_get_free_heap_size();
+    p = profiler_put(p, &u32, 4);
+    u32 = esp_get_minimum_free_heap_size();
+    p = profiler_put(p, &u32, 4);
+
+    /* core load from the idle task of each core */
+    uint8_t load[portNUM_PROCESSORS] = {0};
+    *p++ = portNUM_PROCESSORS;
+
+    for(uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+
+        for(UBaseType_t i = 0; i < task_n; i++)
+        {
+            if(status[i].xHandle != idle) continue;
+
+            uint32_t delta = profiler_task_delta(idle, status[i].ulRunTimeCounter, prev, &prev_n);
+
+            if(elapsed && (delta < elapsed)) load[core] = 100 - (((uint64_t)delta * 100) / elapsed);
+
+            break;
+        }
+
+        *p++ = load[core];
+    }
+
+    /* loop statistic since the previous sample */
+    profiler_loop_stat loops_copy[PROFILER_LOOP_MAX];
+    taskENTER_CRITICAL(&loop_lock);
+    memcpy(loops_copy, loops, sizeof(loops));
+
+    for(uint8_t i = 0; i < PROFILER_LOOP_MAX; i++)
+    {
+        loops[i].miss_n = 0;
+        loops[i].jitter_max = 0;
+        memset(loops[i].hist, 0, sizeof(loops[i].hist));
+    }
+
+    taskEXIT_CRITICAL(&loop_lock);
+    *p++ = PROFILER_LOOP_MAX;
+
+    for(uint8_t i = 0; i < PROFILER_LOOP_MAX; i++)
+    {
+        p = profiler_put(p, &loops_copy[i].miss_n, 4);
+        p = profiler_put(p, &loops_copy[i].jitter_max, 4);
+        p = profiler_put(p, loops_copy[i].hist, sizeof(loops_copy[i].hist));
+    }
+
+    /* the deadline margin of the audio output */
+    ach_refill_stat refill;
+    ach_player_refill_stat(&refill, true);
+    p = profiler_put(p, &refill.refill_n, 4);
+    p = profiler_put(p, &refill.latency_avg, 4);
+    p = profiler_put(p, &refill.latency_max, 4);
+    p = profiler_put(p, &refill.slack_min, 4);
+
+    /* CPU share of each task */
+    *p++ = task_n;
+
+    for(UBaseType_t i = 0; i < task_n; i++)
+    {
+        uint32_t delta = profiler_task_delta(status[i].xHandle, status[i].ulRunTimeCounter, prev, &prev_n);
+        u16 = elapsed ? (((uint64_t)delta * 1000) / elapsed) : 0;
+        p = profiler_put(p, &u16, 2);
+        u32 = status[i].usStackHighWaterMark;
+        p = profiler_put(p, &u32, 4);
+        *p++ = xTaskGetCoreID(status[i].xHandle);
+        p = profiler_put(p, status[i].pcTaskName, strlen(status[i].pcTaskName) + 1);
+    }
+
+    memcpy(tasks_prev, prev, prev_n * sizeof(profiler_task_prev));
+    memset(&tasks_prev[prev_n], 0, (PROFILER_TASK_MAX - prev_n) * sizeof(profiler_task_prev));
+    free(status);
+
+    if(!(++sample_cnt % PROFILER_LOG_N))
+    {
+        ESP_LOGI(TAG, "core load: %d%%, %d%%, DSP missed: %ld, lights missed: %ld, max jitter: %ldus, I2S refill max: %ldus, min slack: %ldus",
+            load[0], load[portNUM_PROCESSORS - 1], loops_copy[PROFILER_LOOP_DSP].miss_n,
+            loops_copy[PROFILER_LOOP_LIGHTS].miss_n, loops_copy[PROFILER_LOOP_LIGHTS].jitter_max,
+            refill.latency_max, refill.slack_min);
+    }
+
+    *len = p - buf;
+    return buf;
+}
+
+static uint8_t *profiler_put(uint8_t *p, const void *src, size_t n)
+{
+    /* frame fields are not aligned, so copy bytewise */
+    memcpy(p, src, n);
+    return p + n;
+}
+
+/* run time since the previous sample, the new run time stored in prev */
+static uint32_t profiler_task_delta(TaskHandle_t handle, uint32_t run_time, profiler_task_prev *prev, uint8_t *prev_n)
+{
+    uint32_t run_time_prev = run_time; // new task: nothing known before
+
+    for(uint8_t i = 0; i < PROFILER_TASK_MAX; i++)
+    {
+        if(tasks_prev[i].handle == handle)
+        {
+            run_time_prev = tasks_prev[i].run_time;
+            break;
+        }
+    }
+
+    /* idle tasks visited twice (core load and task list) */
+    for(uint8_t i = 0; i < *prev_n; i++)
+    {
+        if(prev[i].handle == handle) return run_time - run_time_prev;
+    }
+
+    if(*prev_n < PROFILER_TASK_MAX)
+    {
+        prev[*prev_n] = (profiler_task_prev) {handle, run_time};
+        (*prev_n)++;
+    }
+
+    return run_time - run_time_prev;
+}
@@ -0,0 +1,34 @@
+/*
+ * Runtime profiler (tasks CPU share, loop timing, heap)
+ */
+
+#ifndef __APP_PROFILER_H__
+#define __APP_PROFILER_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+typedef enum {
+    PROFILER_LOOP_DSP,
+    PROFILER_LOOP_LIGHTS,
+    PROFILER_LOOP_MAX
+} profiler_loop_id;
+
+
+/* start_us, end_us: time of the loop work start and end,
+ * missed: the loop period deadline missed (xTaskDelayUntil not delayed) */
+void profiler_loop(profiler_loop_id id, int64_t start_us, int64_t end_us, bool missed);
+/* the loop slept on purpose, the next period not counted to the jitter */
+void profiler_loop_idle(profiler_loop_id id);
+/* collect the statistic since the previous call into a binary frame
+ * (layout in profiler.c), head_len bytes left free at the frame start,
+ * the returned frame has to be freed, NULL on error */
+uint8_t *profiler_sample(size_t head_len, size_t *len);
+
+
+#endif /* __APP_PROFILER_H__ */
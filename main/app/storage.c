@@ -16,6 +16,7 @@ static const char *TAG = LOG_COLOR("33") "cfg" LOG_RESET_COLOR;
 static const char *TAGE = LOG_COLOR("33") "cfg" LOG_COLOR_E;
 
 
+static void config_parse_audio(cJSON *cfg);
 static void config_parse_lights(cJSON *cfg);
 static void parse_lights_strips(cJSON *cfg_strips);
 static void parse_lights_zones(cJSON *cfg_zones, int strip_index);
@@ -99,10 +100,30 @@ void storage_save(cJSON *json)
 void storage_config_parse()
 {
     cJSON *cfg = storage_load();
+    config_parse_audio(cfg);
     config_parse_lights(cfg);
     cJSON_Delete(cfg);
 }
 
+void storage_save_audio_profile(audio_profile_id id)
+{
+    cJSON *cfg = storage_load();
+    cJSON *cfg_audio = cJSON_GetObjectItem(cfg, "audio");
+
+    if(!cJSON_IsObject(cfg_audio))
+    {
+        ESP_LOGI(TAG, "cfg NOT has audio");
+        cJSON_DeleteItemFromObject(cfg, "audio");
+        cfg_audio = cJSON_CreateObject();
+        cJSON_AddItemToObject(cfg, "audio", cfg_audio);
+    }
+
+    cJSON_DeleteItemFromObject(cfg_audio, "profile");
+    cJSON_AddStringToObject(cfg_audio, "profile", audio_profile_get(id)->name);
+    storage_save(cfg);
+    cJSON_Delete(cfg);
+}
+
 void storage_save_lights()
 {
     cJSON *cfg = storage_load();
@@ -123,6 +144,30 @@ void storage_save_lights()
     cJSON_Delete(cfg);
 }
 
+static void config_parse_audio(cJSON *cfg)
+{
+    ESP_LOGI(TAG, "json parse audio start...");
+
+    if(cJSON_HasObjectItem(cfg, "audio"))
+    {
+        ESP_LOGI(TAG, "cfg has audio");
+        cJSON *cfg_audio = cJSON_GetObjectItem(cfg, "audio");
+
+        if(cJSON_HasObjectItem(cfg_audio, "profile"))
+        {
+            char *cfg_profile = cJSON_GetStringValue(cJSON_GetObjectItem(cfg_audio, "profile"));
+            audio_profile_id id = audio_profile_find(cfg_profile);
+
+            if(id < AUDIO_PROFILE_MAX) tasks_audio_profile_select(id, false);
+            else ESP_LOGE(TAGE, "cfg_audio profile unknown: %s", cfg_profile ? cfg_profile : "-");
+        }
+        else ESP_LOGE(TAGE, "cfg_audio NOT has profile");
+    }
+    else ESP_LOGI(TAG, "cfg NOT has audio, default profile used");
+
+    ESP_LOGI(TAG, "json parse audio end");
+}
+
 static void config_parse_lights(cJSON *cfg)
 {
     ESP_LOGI(TAG, "json parse lights start...");
@@ -132,6 +177,13 @@ static void config_parse_lights(cJSON *cfg)
         ESP_LOGI(TAG, "cfg has lights");
         cJSON *cfg_lights = cJSON_GetObjectItem(cfg, "lights");
 
+        /* optional, LIGHTS_GAMMA without it */
+        if(cJSON_HasObjectItem(cfg_lights, "gamma"))
+        {
+            double cfg_gamma = cJSON_GetObjectItem(cfg_lights, "gamma")->valuedouble;
+            lights_set_gamma(cfg_gamma);
+        }
+
         if(cJSON_HasObjectItem(cfg_lights, "strips"))
         {
             ESP_LOGI(TAG, "cfg_lights has strips");
@@ -190,10 +242,24 @@ static void parse_lights_strips(cJSON *cfg_strips)
                     if(char_p) colors.i_b = char_p - cfg_zone_colors;
                     else valid = false;
 
+                    /* optional white LED: RGBW strips, only the one wire ones */
+                    char_p = strchr(cfg_zone_colors, 'W');
+
+                    if(char_p)
+                    {
+                        colors.i_w = char_p - cfg_zone_colors;
+                        colors.white = true;
+
+                        if(MLED_TYPE_APA102 == mled_channels[i].type) valid = false;
+                    }
+
                     if(valid)
                     {
-                        if(colors.i_r > 2 || colors.i_g > 2 || colors.i_b > 2
-                            || colors.i_r == colors.i_g || colors.i_r == colors.i_b || colors.i_g == colors.i_b)
+                        uint8_t i_max = MLED_PIXEL_SIZE(colors) - 1;
+
+                        if(colors.i_r > i_max || colors.i_g > i_max || colors.i_b > i_max || colors.i_w > i_max
+                            || colors.i_r == colors.i_g || colors.i_r == colors.i_b || colors.i_g == colors.i_b
+                            || (colors.white && (colors.i_w == colors.i_r || colors.i_w == colors.i_g || colors.i_w == colors.i_b)))
                         {
                             valid = false;
                         }
@@ -201,6 +267,8 @@ static void parse_lights_strips(cJSON *cfg_strips)
 
                     if(valid)
                     {
+                        /* the pixel format sets the strip buffer size */
+                        mled_channels[i].rgb_order = colors;
                         lights_set_strip_size(i, cfg_strip_pixel_n);
 
                         if(cJSON_HasObjectItem(cfg_strip_item, "zones"))
@@ -254,6 +322,10 @@ static void parse_lights_zones(cJSON *cfg_zones, int strip_index)
                     ESP_LOGI(TAG, "cfg_zone_item %d has shader", i);
                     cJSON *cfg_shader = cJSON_GetObjectItem(cfg_zone_item, "shader");
                     parse_lights_shader(cfg_shader, &zone->shader);
+
+                    /* the FFT bands and palette depend on the zone size */
+                    if(zone->shader.type == SHADER_FFT) lights_shader_init_fft(zone);
+
                     zone->shader.need_render = true;
                 }
                 else ESP_LOGE(TAGE, "cfg_zone_item %d NOT has shader", i);
@@ -274,11 +346,15 @@ static void parse_lights_shader(cJSON *cfg_shader, lights_shader *shader)
         switch(cfg_shader_type)
         {
             case SHADER_SINGLE: parse_lights_shader_single(cfg_shader, shader); break;
-            case SHADER_FADE: parse_lights_shader_repeat(cfg_shader, shader); break;
-            case SHADER_REPEAT: parse_lights_shader_fade(cfg_shader, shader); break;
+            case SHADER_REPEAT: parse_lights_shader_repeat(cfg_shader, shader); break;
+            case SHADER_FADE: parse_lights_shader_fade(cfg_shader, shader); break;
             case SHADER_FFT: parse_lights_shader_fft(cfg_shader, shader); break;
-            default: ERR_BAD_CASE(cfg_shader_type, "%d");
+            default:
+                ERR_BAD_CASE(cfg_shader_type, "%d");
+                return;
         }
+
+        shader->type = cfg_shader_type;
     }
     else ESP_LOGE(TAGE, "cfg_shader NOT has type");
 }
@@ -437,10 +513,11 @@ static int parse_lights_colors_hsl(cJSON *cfg_colors, color_hsl **colors)
 
 static void config_update_lights(cJSON *cfg_lights)
 {
+    cJSON_AddNumberToObject(cfg_lights, "gamma", lights_get_gamma());
     cJSON *cfg_strips = cJSON_CreateArray();
     cJSON_AddItemToObject(cfg_lights, "strips", cfg_strips);
-    /* RGB + zero ending */
-    char rgb_order_str[4] = {0};
+    /* RGBW + zero ending */
+    char rgb_order_str[MLED_PIXEL_SIZE_MAX + 1];
 
     for(uint8_t strip_index = 0; strip_index < MLED_STRIP_N; strip_index++)
     {
@@ -448,9 +525,13 @@ static void config_update_lights(cJSON *cfg_lights)
         cJSON *cfg_strip_item = cJSON_CreateObject();
         cJSON_AddNumberToObject(cfg_strip_item, "pixel_n", strip->pixels.pixel_n);
         mled_rgb_order rgb_order = strip->rgb_order;
+        memset(rgb_order_str, 0, sizeof(rgb_order_str));
         rgb_order_str[rgb_order.i_r] = 'R';
         rgb_order_str[rgb_order.i_g] = 'G';
         rgb_order_str[rgb_order.i_b] = 'B';
+
+        if(rgb_order.white) rgb_order_str[rgb_order.i_w] = 'W';
+
         cJSON_AddStringToObject(cfg_strip_item, "rgb_order", rgb_order_str);
         lights_zone_chain *zone = lights_zones[strip_index].first;
 
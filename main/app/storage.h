@@ -8,14 +8,20 @@
 
 #include "cJSON.h"
 
+#include "audio_profile.h"
 
+
+/* the host build sets its own */
+#ifndef STORAGE_PATH_CONFIG
 #define STORAGE_PATH_CONFIG "/spiffs/config.json"
+#endif
 
 
 cJSON *storage_load(void);
 void storage_save(cJSON *json);
 void storage_config_parse();
 void storage_save_lights();
+void storage_save_audio_profile(audio_profile_id id);
 
 
 #endif /* STORAGE_H */
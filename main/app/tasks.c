@@ -3,6 +3,9 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "freertos/ringbuf.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_pm.h"
 
 #include "app_config.h"
 #include "app_tools.h"
@@ -11,7 +14,15 @@
 #include "bt_profiles.h"
 #include "lights.h"
 #include "dsp.h"
+#include "limiter.h"
+#include "conceal.h"
+#include "audio_profile.h"
 #include "storage.h"
+#include "profiler.h"
+#include "instr.h"
+#include "trace.h"
+#include "capture.h"
+#include "latency.h"
 
 
 typedef enum {
@@ -25,14 +36,26 @@ typedef enum {
 } audio_state_t;
 
 
-static void tasks_throttler();
-static void tasks_handle_throttled_signal(tasks_signal_throttled *signal);
-static void tasks_send_throttled_signal(tasks_signal signal, TickType_t throttle_min_time);
+static void tasks_throttle_timer_callback(void *arg);
+static void tasks_throttled_acknowledge(tasks_instance task, tasks_signal_type type);
+static bool tasks_throttled_take_waiting(tasks_signal_throttled *sig_throt, tasks_signal *signal);
+static void tasks_throttled_deliver(tasks_signal_throttled *sig_throt, tasks_signal signal);
+static void tasks_send_throttled_signal(tasks_signal signal, uint32_t throttle_min_ms);
 static void tasks_audio_player();
+static bool tasks_audio_refill();
+static void tasks_audio_drain();
+static void tasks_audio_profile_apply();
 static void tasks_audio_state(audio_state_t new_state);
+static bool tasks_audio_trim(const int16_t *frames, size_t frame_n, size_t cut_n);
 static bool tasks_audio_stream_prepare();
 static void tasks_audio_stream_terminate();
 static void tasks_signal_send(tasks_signal signal);
+static uint8_t tasks_mail_receive(tasks_instance task, TickType_t tick, tasks_signal *signals);
+#if TASKS_MAIL_BENCHMARK_ENABLE
+static void tasks_mail_benchmark();
+#endif
+static void tasks_pm_hold(esp_pm_lock_handle_t lock, bool hold);
+static void tasks_lights_wake();
 static void tasks_dsp();
 static void tasks_lights();
 // static void throttled_signal_dumb(tasks_signal_throttled *signal);
@@ -40,8 +63,10 @@ static void tasks_lights();
 
 static const char *TAG = LOG_COLOR("91") "TASK" LOG_RESET_COLOR;
 static const char *TAGE = LOG_COLOR("91") "TASK" LOG_COLOR_E;
-/* used for handling throttled signals */
+/* used for creating the throttle timers */
 static SemaphoreHandle_t throttler_semaphore = NULL;
+/* used for make thread safe the throttled signal states (also from timer callback) */
+static portMUX_TYPE throttler_lock = portMUX_INITIALIZER_UNLOCKED;
 /* used for make thread safe the audio state changeing */
 static SemaphoreHandle_t audio_semaphore = NULL;
 /* used for make thread safe the DSP internal ringbuf r/w */
@@ -50,14 +75,27 @@ static SemaphoreHandle_t dsp_in_semaphore = NULL;
 static SemaphoreHandle_t dsp_out_semaphore = NULL;
 /* used for make thread safe the lights zone configs */
 static SemaphoreHandle_t lights_semaphore = NULL;
-static QueueHandle_t mails_audio_player = NULL;
-static QueueHandle_t mails_lights= NULL;
+/* CPU max frequency hold while audio streaming and while lights animating */
+static esp_pm_lock_handle_t pm_lock_audio = NULL;
+static esp_pm_lock_handle_t pm_lock_lights = NULL;
+static tasks_mailbox mailboxes[TASKS_INST_MAX] = {0}; // argument slots locked with their own lock
 static RingbufHandle_t audio_stream_ringbuf = NULL;
-static tasks_signal_throttled throttled_signals[TASKS_INST_MAX][TASKS_SIG_MAX] = {0}; // semaphored with throttler_semaphore
+static tasks_signal_throttled throttled_signals[TASKS_INST_MAX][TASKS_SIG_MAX] = {0}; // locked with throttler_lock
 static audio_state_t audio_state = AUDIO_STATE_INIT; // semaphored with audio_semaphore
 static size_t dropped_bytes = 0; // semaphored with audio_semaphore
-static size_t rip_count = 0;
-static size_t rip_sum = 0;
+static size_t trimmed_bytes = 0; // used only from Bluetooth stack context
+/* buffering profile, selected from any context,
+ * applied by the audio player only while audio stream off */
+static volatile audio_profile_id profile_selected = AUDIO_PROFILE_DEFAULT;
+static audio_profile_id profile_active = AUDIO_PROFILE_DEFAULT;
+static const audio_profile *profile = NULL;
+/* the selected profile stored to config.json after applied */
+static volatile bool profile_save = false;
+/* ringbuf became empty while playing, waiting new data or conceal the gap,
+ * written by the audio player, read also by tasks_audio_data */
+static volatile bool underrun_wait = false;
+/* the limiter delay line drained, then the fade out */
+static int16_t underrun_fill[(LIMITER_DELAY_FRAMES + CONCEAL_FADE_FRAMES) * AUDIO_CHANNEL_N] = {0};
 
 
 void tasks_create()
@@ -78,16 +116,27 @@ void tasks_create()
     lights_semaphore = xSemaphoreCreateBinary();
     ERR_IF_NULL_RESET(lights_semaphore);
     xSemaphoreGive(lights_semaphore);
-    mails_audio_player = xQueueCreate(10, sizeof(tasks_signal));
-    ERR_IF_NULL_RESET(mails_audio_player);
-    mails_lights = xQueueCreate(3, sizeof(tasks_signal));
-    ERR_IF_NULL_RESET(mails_lights);
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = PM_CPU_FREQ_MIN_MHZ,
+        .light_sleep_enable = false
+    };
+    ERR_CHECK(esp_pm_configure(&pm_config));
+    ERR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "audio", &pm_lock_audio));
+    ERR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "lights", &pm_lock_lights));
+#endif
+
+    for(uint8_t i = 0; i < TASKS_INST_MAX; i++) portMUX_INITIALIZE(&mailboxes[i].lock);
+
     ESP_LOGI(TAG, "init variables OK");
+#if TASKS_MAIL_BENCHMARK_ENABLE
+    tasks_mail_benchmark();
+#endif
 
-    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_throttler, "Throttler", 1984, NULL, 12, NULL, 1));
-    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_audio_player, "Audio Player", 2304, NULL, 12, NULL, 1));
-    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_dsp, "DSP", 2048, NULL, 12, NULL, 1));
-    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_lights, "Lights", 2176, NULL, 12, NULL, 1));
+    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_audio_player, "Audio Player", 2304, NULL, 12, &mailboxes[TASKS_INST_AUDIO_PLAYER].task, TASKS_CORE_AUDIO_PLAYER));
+    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_dsp, "DSP", 2048, NULL, 12, &mailboxes[TASKS_INST_AUDIO_DSP].task, TASKS_CORE_DSP));
+    ERR_CHECK_RESET(pdPASS != xTaskCreatePinnedToCore(tasks_lights, "Lights", 2176, NULL, 12, &mailboxes[TASKS_INST_LIGHT].task, TASKS_CORE_LIGHTS));
     ESP_LOGI(TAG, "create tasks OK");
 }
 
@@ -108,10 +157,18 @@ void tasks_message(tasks_signal signal)
         case TASKS_SIG_AUDIO_STREAM_STARTED:
         case TASKS_SIG_AUDIO_STREAM_SUSPEND:
         case TASKS_SIG_AUDIO_DATA_SUFFICIENT:
+        case TASKS_SIG_AUDIO_PROFILE:
             tasks_signal_send(signal);
             break;
         case TASKS_SIG_AUDIO_VOLUME:
-            tasks_send_throttled_signal(signal, pdMS_TO_TICKS(200));
+            tasks_send_throttled_signal(signal, TASKS_THROTTLE_VOLUME_MS);
+            break;
+        case TASKS_SIG_CONFIG_LIGHTS_SAVE:
+        case TASKS_SIG_CONFIG_AUDIO_SAVE:
+            tasks_send_throttled_signal(signal, TASKS_THROTTLE_CONFIG_SAVE_MS);
+            break;
+        case TASKS_SIG_LIGHTS_WAKE:
+            tasks_signal_send(signal);
             break;
         default:
             ESP_LOGE(TAGE, "signal task: %d, signal type: %d", signal.aim_task, signal.type);
@@ -121,6 +178,9 @@ void tasks_message(tasks_signal signal)
 
 void tasks_audio_data(const uint8_t *data, size_t size)
 {
+    capture_packet(data, size);
+    latency_audio_in(data, size);
+
     if(pdTRUE == xSemaphoreTake(dsp_in_semaphore, portMAX_DELAY))
     {
         dsp_new_data(data, size);
@@ -160,7 +220,7 @@ void tasks_audio_data(const uint8_t *data, size_t size)
     vRingbufferGetInfo(audio_stream_ringbuf, &buf_pos_free, NULL, NULL, &buf_pos_acquire, &buf_waiting);
     /* free size calculatin method copied from ringbuf.c > prvGetCurMaxSizeByteBuf */
     BaseType_t free_size = buf_pos_free - buf_pos_acquire;
-    if(free_size <= 0) free_size += AUDIO_BUF_LEN;
+    if(free_size <= 0) free_size += profile->ring_frames * CONCEAL_FRAME_SIZE;
 
     if(size < free_size)
     {
@@ -179,31 +239,47 @@ void tasks_audio_data(const uint8_t *data, size_t size)
 
     if(drop)
     {
-        if(audio_state == AUDIO_STATE_PRELOAD) force_wakeup_notify = true;
-
-        tasks_audio_state(AUDIO_STATE_DROP);
-        size_t actual_size = size < free_size ? size : free_size;
-        /* size always have to a multiplication of
-         * AUDIO_SAMPLE_BYTE_LEN * AUDIO_CHANNEL_N
-         * (removing last 2 bit makes number divisible by 4) */
-        actual_size &= ~3;
+        /* ringbuf accepts only less data than the free size,
+         * the packet shortened to fit with a crossfaded cut instead of truncating */
+        size_t frame_n = size / CONCEAL_FRAME_SIZE;
+        size_t fit_n = (free_size - 1) / CONCEAL_FRAME_SIZE;
 
-        if(pdTRUE != xRingbufferSend(audio_stream_ringbuf, data, actual_size, 0))
+        if((fit_n < frame_n) && tasks_audio_trim((const int16_t*)data, frame_n, frame_n - fit_n))
         {
-            PRINT_TRACE();
-            actual_size = 0;
+            drop = false;
+            buf_waiting += fit_n * CONCEAL_FRAME_SIZE;
+            trimmed_bytes += size - (fit_n * CONCEAL_FRAME_SIZE);
+
+            if(audio_state == AUDIO_STATE_READY)
+            {
+                tasks_audio_state(AUDIO_STATE_PRELOAD);
+            }
         }
+    }
+
+    if(!drop) trace_event(TRACE_RING_FILL, buf_waiting);
+
+    if(drop)
+    {
+        if(audio_state == AUDIO_STATE_PRELOAD) force_wakeup_notify = true;
+
+        /* not even a trimmed packet fits, whole packet dropped */
+        tasks_audio_state(AUDIO_STATE_DROP);
 
         if(pdTRUE == xSemaphoreTake(audio_semaphore, portMAX_DELAY))
         {
-            dropped_bytes += size - actual_size;
+            dropped_bytes += size;
             xSemaphoreGive(audio_semaphore);
         }
         else PRINT_TRACE();
     }
     else if(audio_state == AUDIO_STATE_PRELOAD)
     {
-        if(buf_waiting >= AUDIO_BUF_TRIGGER_LEVEL)
+        /* after an underrun the DMA still plays the queued buffers,
+         * a whole DMA buffer continues it before the concealment needed */
+        size_t trigger_frames = underrun_wait ? profile->dma_buf_frames : profile->trigger_frames;
+
+        if(buf_waiting >= (trigger_frames * CONCEAL_FRAME_SIZE))
         {
             tasks_audio_state(AUDIO_STATE_PLAY);
             force_wakeup_notify = true;
@@ -220,92 +296,166 @@ void tasks_audio_data(const uint8_t *data, size_t size)
     }
 }
 
+bool tasks_audio_latency(uint32_t *latency_us)
+{
+    /* same context as tasks_audio_data, the ringbuf exists while playing */
+    if((audio_state < AUDIO_STATE_PLAY) || !audio_stream_ringbuf) return false;
+
+    UBaseType_t buf_waiting = 0;
+    vRingbufferGetInfo(audio_stream_ringbuf, NULL, NULL, NULL, NULL, &buf_waiting);
+    /* while playing the DMA buffers are kept full by the on_sent refill */
+    uint32_t frame_n = (buf_waiting / CONCEAL_FRAME_SIZE)
+        + (profile->dma_buf_n * profile->dma_buf_frames)
+        + LIMITER_DELAY_FRAMES;
+    *latency_us = (((uint64_t)frame_n * 1000000) / AUDIO_SAMPLE_RATE) + A2DP_DELAY_CODEC_US;
+    return true;
+}
+
+void tasks_audio_profile_select(audio_profile_id id, bool save)
+{
+    if(id >= AUDIO_PROFILE_MAX)
+    {
+        ERR_BAD_CASE(id, "%d");
+        return;
+    }
+
+    profile_save = save;
+    profile_selected = id;
+    /* the audio player applies it now or after the audio stream */
+    tasks_signal signal = {
+        .aim_task = TASKS_INST_AUDIO_PLAYER,
+        .type = TASKS_SIG_AUDIO_PROFILE
+    };
+    tasks_message(signal);
+}
+
+void tasks_audio_profile(audio_profile_id *selected, audio_profile_id *active)
+{
+    *selected = profile_selected;
+    *active = profile_active;
+}
+
 bool tasks_lights_lock()
 {
-    ERR_CHECK_RETURN_VAL(pdTRUE == xSemaphoreTake(lights_semaphore, portMAX_DELAY), false);
+    ERR_CHECK_RETURN_VAL(pdTRUE != xSemaphoreTake(lights_semaphore, portMAX_DELAY), false);
     return true;
 }
 
 void tasks_lights_release()
 {
     xSemaphoreGive(lights_semaphore);
+    /* the config changed, the lights maybe sleeping */
+    tasks_lights_wake();
 }
 
-static void tasks_throttler()
+static bool tasks_audio_trim(const int16_t *frames, size_t frame_n, size_t cut_n)
 {
-    ESP_LOGI(TAG, "throttler started");
-    TickType_t lastWakeTime;
+    /* only called from Bluetooth stack context */
+    static conceal_trim_res trim;
 
-    ESP_LOGI(TAG, "throttler enter infinite loop");
-    while(1)
+    if(!conceal_trim(frames, frame_n, cut_n, &trim)) return false;
+
+    trace_event(TRACE_CONCEAL, 0);
+
+    if(trim.head_n)
     {
-        lastWakeTime = xTaskGetTickCount();
+        ERR_CHECK(pdTRUE != xRingbufferSend(audio_stream_ringbuf, frames, trim.head_n * CONCEAL_FRAME_SIZE, 0));
+    }
 
-        for(uint8_t task_i = 0; task_i < TASKS_INST_MAX; task_i++)
-        {
-            for(uint8_t sig_i = 0; sig_i < TASKS_SIG_MAX; sig_i++)
-            {
-                tasks_handle_throttled_signal(&throttled_signals[task_i][sig_i]);
-            }
-        }
+    ERR_CHECK(pdTRUE != xRingbufferSend(audio_stream_ringbuf, trim.xfade, sizeof(trim.xfade), 0));
 
-        xTaskDelayUntil(&lastWakeTime, TASKS_THROTTLE_MIN_TIME);
+    if(trim.tail_n)
+    {
+        ERR_CHECK(pdTRUE != xRingbufferSend(audio_stream_ringbuf, &frames[trim.tail_pos * AUDIO_CHANNEL_N], trim.tail_n * CONCEAL_FRAME_SIZE, 0));
     }
+
+    return true;
 }
 
-static void tasks_handle_throttled_signal(tasks_signal_throttled *signal)
+static void tasks_throttle_timer_callback(void *arg)
 {
-    if(pdTRUE != xSemaphoreTake(throttler_semaphore, portMAX_DELAY)) return;
+    /* min throttle time ellapsed since the last delivered signal */
+    tasks_signal_throttled *sig_throt = (tasks_signal_throttled*)arg;
+    tasks_signal signal;
+    bool need_send = false;
+
+    taskENTER_CRITICAL(&throttler_lock);
+    sig_throt->expired = true;
+
+    /* detect task still not processed previous signal,
+     * to not overwrite its unprocessed signal in the mailbox,
+     * signal will sent when task acknowledged */
+    if(!sig_throt->need_acknowledge) need_send = tasks_throttled_take_waiting(sig_throt, &signal);
 
+    taskEXIT_CRITICAL(&throttler_lock);
+
+    if(need_send) tasks_throttled_deliver(sig_throt, signal);
+}
+
+static void tasks_throttled_acknowledge(tasks_instance task, tasks_signal_type type)
+{
+    tasks_signal_throttled *sig_throt = &throttled_signals[task][type];
+    tasks_signal signal;
     bool need_send = false;
 
-    if(signal->live)
+    taskENTER_CRITICAL(&throttler_lock);
+
+    if(sig_throt->need_acknowledge)
     {
-        // ESP_LOGW(TAG, "BEGIN %s", __func__);
-        // throttled_signal_dumb(signal);
+        sig_throt->need_acknowledge = false;
 
-        if(signal->started)
-        {
-            if(signal->tick_left > TASKS_THROTTLE_MIN_TIME)
-            {
-                signal->tick_left -= TASKS_THROTTLE_MIN_TIME;
-            }
-            else
-            {
-                /* detect task still not processed previous signal,
-                * to prevent task's mailbox queue overflow,
-                * signal will sent after task acknowledged */
-                if(!signal->need_acknowledge)
-                {
-                    if(signal->need_send)
-                    {
-                        need_send = true;
-                        signal->need_send = false;
-                        signal->need_acknowledge = true;
-                    }
+        if(sig_throt->expired) need_send = tasks_throttled_take_waiting(sig_throt, &signal);
+    }
 
-                    signal->tick_left = 0;
-                    signal->live = false;
-                    signal->started = false;
-                }
-            }
-        }
-        else
-        {
-            /* this provide min throttle time ellapsed */
-            signal->started = true;
-        }
+    taskEXIT_CRITICAL(&throttler_lock);
+
+    if(need_send) tasks_throttled_deliver(sig_throt, signal);
+}
 
-        // ESP_LOGW(TAG, "END %s", __func__);
-        // throttled_signal_dumb(signal);
+/* must be called in throttler_lock critical section,
+ * true if the waiting signal has to be delivered now,
+ * else the throttling ends */
+static bool tasks_throttled_take_waiting(tasks_signal_throttled *sig_throt, tasks_signal *signal)
+{
+    if(!sig_throt->need_send)
+    {
+        sig_throt->live = false;
+        return false;
     }
 
-    xSemaphoreGive(throttler_semaphore);
+    *signal = sig_throt->waiting_signal;
+    sig_throt->need_send = false;
+    sig_throt->need_acknowledge = true;
+    sig_throt->expired = false;
+    sig_throt->latency_us = esp_timer_get_time() - sig_throt->waiting_since;
+    return true;
+}
+
+static void tasks_throttled_deliver(tasks_signal_throttled *sig_throt, tasks_signal signal)
+{
+    /* the next signal not sent before the min throttle time again */
+    ERR_CHECK(esp_timer_start_once(sig_throt->timer, sig_throt->min_time_us));
+    tasks_signal_send(signal);
+
+    /* latency: time between the (first coalesced) request and the delivery,
+     * only accessed by the actual deliverer */
+    sig_throt->stat_latency_sum += sig_throt->latency_us;
 
-    if(need_send) tasks_message(signal->waiting_signal);
+    if(sig_throt->latency_us > sig_throt->stat_latency_max) sig_throt->stat_latency_max = sig_throt->latency_us;
+
+    if(TASKS_THROTTLE_LOG_N <= ++sig_throt->stat_sent)
+    {
+        ESP_LOGI(TAG, "throttled signal task: %d, type: %d, sent: %ld, coalesced: %ld, latency avg: %lldus, max: %lldus",
+            signal.aim_task, signal.type, sig_throt->stat_sent, sig_throt->stat_coalesced,
+            sig_throt->stat_latency_sum / sig_throt->stat_sent, sig_throt->stat_latency_max);
+        sig_throt->stat_sent = 0;
+        sig_throt->stat_coalesced = 0;
+        sig_throt->stat_latency_sum = 0;
+        sig_throt->stat_latency_max = 0;
+    }
 }
 
-static void tasks_send_throttled_signal(tasks_signal signal, TickType_t throttle_min_time)
+static void tasks_send_throttled_signal(tasks_signal signal, uint32_t throttle_min_ms)
 {
     // switch(signal.type)
     // {
@@ -317,14 +467,38 @@ static void tasks_send_throttled_signal(tasks_signal signal, TickType_t throttle
     //     default: ERR_BAD_CASE(signal.type, "%d");
     // }
 
-    bool immediate = false;
     tasks_signal_throttled *sig_throt = &throttled_signals[signal.aim_task][signal.type];
-    ERR_CHECK_RETURN(pdTRUE != xSemaphoreTake(throttler_semaphore, portMAX_DELAY));
-    // ESP_LOGW(TAG, "BEGIN %s", __func__);
+    bool immediate = false;
+
+    /* one-shot timer created at the first use of the signal */
+    if(!sig_throt->timer)
+    {
+        ERR_CHECK_RETURN(pdTRUE != xSemaphoreTake(throttler_semaphore, portMAX_DELAY));
+
+        if(!sig_throt->timer)
+        {
+            esp_timer_create_args_t timer_args = {
+                .callback = tasks_throttle_timer_callback,
+                .arg = sig_throt,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "throttle"
+            };
+            ERR_CHECK(esp_timer_create(&timer_args, &sig_throt->timer));
+        }
+
+        xSemaphoreGive(throttler_semaphore);
+        ERR_IF_NULL_RETURN(sig_throt->timer);
+    }
+
+    taskENTER_CRITICAL(&throttler_lock);
     // throttled_signal_dumb(sig_throt);
 
     if(sig_throt->live)
     {
+        /* only the last one delivered, the latency counts from the first */
+        if(sig_throt->need_send) sig_throt->stat_coalesced++;
+        else sig_throt->waiting_since = esp_timer_get_time();
+
         sig_throt->need_send = true;
         sig_throt->waiting_signal = signal;
     }
@@ -332,38 +506,53 @@ static void tasks_send_throttled_signal(tasks_signal signal, TickType_t throttle
     {
         immediate = true;
         sig_throt->live = true;
+        sig_throt->expired = false;
         sig_throt->need_acknowledge = true;
-        sig_throt->tick_left = throttle_min_time;
+        sig_throt->min_time_us = throttle_min_ms * 1000;
+        sig_throt->latency_us = 0;
     }
 
-    // ESP_LOGW(TAG, "END %s", __func__);
-    // throttled_signal_dumb(sig_throt);
-    xSemaphoreGive(throttler_semaphore);
+    taskEXIT_CRITICAL(&throttler_lock);
 
-    if(immediate) tasks_signal_send(signal);
+    if(immediate) tasks_throttled_deliver(sig_throt, signal);
 }
 
 static void tasks_audio_player()
 {
     ESP_LOGI(TAG, "audio player started");
+    tasks_signal signals[TASKS_SIG_MAX];
     tasks_signal signal;
+    uint8_t signal_n;
     TickType_t tick;
-    uint32_t total_dma_buf_size = I2S_DMA_BUF_SIZE * I2S_DMA_BUF_N;
+    /* playing in the previous loop, the refill timing measurable only then */
+    bool playing = false;
+    /* sent out DMA buffers not refilled yet, kept while the ringbuf has no whole buffer */
+    uint32_t refill_n = 0;
     /* init audio peripheral */
     ach_control_init();
-    ach_player_init(&total_dma_buf_size);
+    profile = audio_profile_get(profile_active);
+    ERR_CHECK_RESET(!ach_player_init(profile->dma_buf_n, profile->dma_buf_frames, xTaskGetCurrentTaskHandle()));
+    limiter_init();
     tasks_audio_state(AUDIO_STATE_STOP);
 
     ESP_LOGI(TAG, "audio player enter infinite loop");
     while(1)
     {
-        signal = (tasks_signal) {.type = TASKS_SIG_UNKNOWN, .aim_task = TASKS_INST_UNKNOWN};
         /* if audio stream ongoing, no block the audio playing */
         if(audio_state >= AUDIO_STATE_PLAY) tick = 0;
+        else if(underrun_wait)
+        {
+            /* part of the DMA play out time: frames * 1000 / AUDIO_SAMPLE_RATE * percent / 100 [ms] */
+            tick = pdMS_TO_TICKS((profile->dma_buf_n * profile->dma_buf_frames * 10 * CONCEAL_UNDERRUN_WAIT_PERCENT) / AUDIO_SAMPLE_RATE);
+        }
         else tick = portMAX_DELAY;
 
-        if(pdTRUE == xQueueReceive(mails_audio_player, &signal, tick))
+        signal_n = tasks_mail_receive(TASKS_INST_AUDIO_PLAYER, tick, signals);
+
+        for(uint8_t i = 0; i < signal_n; i++)
         {
+            signal = signals[i];
+
             switch(signal.type)
             {
                 case TASKS_SIG_AUDIO_STREAM_STARTED: {
@@ -392,7 +581,7 @@ static void tasks_audio_player()
                 }
                 case TASKS_SIG_AUDIO_DATA_SUFFICIENT: {
                     // ESP_LOGI(TAG, "%s AUDIO_DATA_SUFFICIENT", __func__);
-                    /* just wake up from xQueueReceive to start playing audio */
+                    /* just wake up from tasks_mail_receive to start playing audio */
                     break;
                 }
                 case TASKS_SIG_AUDIO_VOLUME: {
@@ -400,44 +589,59 @@ static void tasks_audio_player()
                     ach_volume(signal.arg.audio_volume.volume);
                     break;
                 }
+                case TASKS_SIG_AUDIO_PROFILE: {
+                    ESP_LOGI(TAG, "%s AUDIO_PROFILE", __func__);
+
+                    /* while audio stream on, applied at its terminate */
+                    if(audio_state == AUDIO_STATE_STOP) tasks_audio_profile_apply();
+
+                    break;
+                }
                 default:
                     ERR_BAD_CASE(signal.type, "%d");
             }
 
-            if(throttled_signals[TASKS_INST_AUDIO_PLAYER][signal.type].need_acknowledge)
-            {
-                // ESP_LOGW(TAG, "signal acknowledged %d", signal.type);
-                throttled_signals[TASKS_INST_AUDIO_PLAYER][signal.type].need_acknowledge = false;
-            }
+            // ESP_LOGW(TAG, "signal acknowledged %d", signal.type);
+            tasks_throttled_acknowledge(TASKS_INST_AUDIO_PLAYER, signal.type);
+        }
+
+        if(!signal_n && underrun_wait && (audio_state < AUDIO_STATE_PLAY))
+        {
+            /* new data not arrived in time, I2S DMA will run out soon,
+             * fade out instead of the hard cut to the auto cleared silence */
+            underrun_wait = false;
+            /* the limiter look-ahead holds the last frames before the gap, the fade out continues them,
+             * the delay line empty after, so the fade in starts when the new data comes out of it */
+            limiter_drain(underrun_fill);
+            conceal_played(underrun_fill, LIMITER_DELAY_FRAMES);
+            conceal_fill(&underrun_fill[LIMITER_DELAY_FRAMES * AUDIO_CHANNEL_N], LIMITER_DELAY_FRAMES);
+            trace_event(TRACE_CONCEAL, 1);
+            ach_player_data(underrun_fill, sizeof(underrun_fill));
+            ESP_LOGW(TAG, "audio underrun concealed");
         }
 
         if(audio_state >= AUDIO_STATE_PLAY)
         {
             size_t item_size;
-            void *data;
-            size_t flush_cnt = 0;
             bool more_data_left = true;
+            /* wait until a DMA buffer sent out (on_sent notification),
+             * after (re)start refill the buffers sent out while not playing */
+            refill_n += ulTaskNotifyTake(pdTRUE, playing ? pdMS_TO_TICKS(100) : 0);
 
-            do
-            {
-                item_size = 0;
-                data = xRingbufferReceiveUpTo(audio_stream_ringbuf, &item_size, 0, AUDIO_BUF_RECEIVE_SIZE);
+            /* the I2S driver keeps max dma_buf_n - 1 sent out buffers to refill */
+            if(refill_n > (profile->dma_buf_n - 1)) refill_n = profile->dma_buf_n - 1;
 
-                if(item_size)
-                {
-                    ach_player_data(data, item_size);
-                    vRingbufferReturnItem(audio_stream_ringbuf, data);
-                }
-                else
+            if(refill_n)
+            {
+                while(refill_n && more_data_left)
                 {
-                    more_data_left = false;
-                    break;
+                    more_data_left = tasks_audio_refill();
+
+                    if(more_data_left) refill_n--;
                 }
 
-                if(flush_cnt < AUDIO_BUF_MAX_FLUSH_N) flush_cnt++;
-                else break;
+                ach_player_refilled(playing);
             }
-            while(item_size);
 
             if(more_data_left)
             {
@@ -445,7 +649,7 @@ static void tasks_audio_player()
                 {
                     vRingbufferGetInfo(audio_stream_ringbuf, NULL, NULL, NULL, NULL, &item_size);
 
-                    if(item_size < AUDIO_BUF_TRIGGER_LEVEL)
+                    if(item_size < (profile->trigger_frames * CONCEAL_FRAME_SIZE))
                     {
                         tasks_audio_state(AUDIO_STATE_PLAY);
                     }
@@ -455,6 +659,9 @@ static void tasks_audio_player()
             {
                 if(audio_state == AUDIO_STATE_FLUSH)
                 {
+                    underrun_wait = false;
+                    refill_n = 0;
+                    tasks_audio_drain();
                     tasks_audio_state(AUDIO_STATE_STOP);
                     tasks_audio_stream_terminate();
                 }
@@ -464,9 +671,102 @@ static void tasks_audio_player()
                      * if new data comes, have to wake up this task with any task message,
                      * TASKS_SIG_AUDIO_DATA_SUFFICIENT signal can be used for this purpose */
                     tasks_audio_state(AUDIO_STATE_READY);
+                    underrun_wait = true;
                 }
             }
         }
+
+        playing = (audio_state >= AUDIO_STATE_PLAY);
+    }
+}
+
+static bool tasks_audio_refill()
+{
+    /* exactly one DMA buffer */
+    size_t need = profile->dma_buf_frames * CONCEAL_FRAME_SIZE;
+    size_t item_size;
+    void *data;
+
+    /* only whole DMA buffers while streaming, a partial one would play out
+     * with silence at its end (a click), that gap is left to the concealment,
+     * only the stream end written partially */
+    vRingbufferGetInfo(audio_stream_ringbuf, NULL, NULL, NULL, NULL, &item_size);
+
+    if((item_size < need) && (audio_state != AUDIO_STATE_FLUSH)) return false;
+
+    /* ringbuf may return less data at its wrap around point,
+     * so collect one DMA buffer from more items */
+    while(need)
+    {
+        item_size = 0;
+        data = xRingbufferReceiveUpTo(audio_stream_ringbuf, &item_size, 0, need);
+
+        if(!item_size) return false;
+
+        /* item size always a multiplication of the frame size,
+         * because packets are pushed into the ringbuf that way */
+        limiter_process((int16_t*)data, item_size / CONCEAL_FRAME_SIZE);
+        conceal_played((int16_t*)data, item_size / CONCEAL_FRAME_SIZE);
+        ach_player_data(data, item_size);
+        underrun_wait = false;
+        vRingbufferReturnItem(audio_stream_ringbuf, data);
+        need -= item_size;
+    }
+
+    return true;
+}
+
+static void tasks_audio_drain()
+{
+    /* the stream end still in the limiter look-ahead */
+    limiter_drain(underrun_fill);
+    conceal_played(underrun_fill, LIMITER_DELAY_FRAMES);
+    ach_player_data(underrun_fill, LIMITER_DELAY_FRAMES * CONCEAL_FRAME_SIZE);
+
+    /* the channel stop drops the queued DMA buffers, wait until they played out */
+    for(uint8_t i = 0; i < profile->dma_buf_n; i++)
+    {
+        if(!ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(100))) break;
+    }
+}
+
+static void tasks_audio_profile_apply()
+{
+    audio_profile_id id = profile_selected;
+
+    if(id == profile_active) return;
+
+    /* I2S channel re-created with the new DMA buffers,
+     * the ringbuf created with the new size at the next audio stream */
+    const audio_profile *new_profile = audio_profile_get(id);
+    ach_player_deinit();
+
+    if(!ach_player_init(new_profile->dma_buf_n, new_profile->dma_buf_frames, xTaskGetCurrentTaskHandle()))
+    {
+        ESP_LOGE(TAGE, "audio profile %s can't applied, back to %s", new_profile->name, profile->name);
+        ERR_CHECK_RESET(!ach_player_init(profile->dma_buf_n, profile->dma_buf_frames, xTaskGetCurrentTaskHandle()));
+        profile_selected = profile_active;
+        return;
+    }
+
+    profile_active = id;
+    profile = new_profile;
+    ESP_LOGI(TAG, "audio profile: %s", profile->name);
+
+    if(profile_save)
+    {
+        /* the config file written by the lights task, not in the audio path */
+        profile_save = false;
+        tasks_signal signal = {
+            .aim_task = TASKS_INST_LIGHT,
+            .type = TASKS_SIG_CONFIG_AUDIO_SAVE,
+            .arg = {
+                .audio_profile = {
+                    .id = id
+                }
+            }
+        };
+        tasks_message(signal);
     }
 }
 
@@ -488,6 +788,8 @@ static void tasks_audio_state(audio_state_t new_state)
 
     if(pdTRUE == xSemaphoreTake(audio_semaphore, portMAX_DELAY))
     {
+        bool streaming = (audio_state >= AUDIO_STATE_READY);
+
         if(audio_state == AUDIO_STATE_DROP)
         {
             ESP_LOGE(TAGE, "dropped bytes: %d", dropped_bytes);
@@ -497,6 +799,16 @@ static void tasks_audio_state(audio_state_t new_state)
 
         audio_state = new_state;
         xSemaphoreGive(audio_semaphore);
+        trace_event(TRACE_AUDIO_STATE, new_state);
+
+        if(!streaming && (new_state >= AUDIO_STATE_READY))
+        {
+            /* max CPU frequency before the first packet, wake up the sleeping loops */
+            tasks_pm_hold(pm_lock_audio, true);
+            xTaskNotifyGive(mailboxes[TASKS_INST_AUDIO_DSP].task);
+            tasks_lights_wake();
+        }
+        else if(streaming && (new_state < AUDIO_STATE_READY)) tasks_pm_hold(pm_lock_audio, false);
     }
     else PRINT_TRACE();
 }
@@ -506,7 +818,7 @@ static bool tasks_audio_stream_prepare()
     bool ret = false;
 
     if(audio_stream_ringbuf) ESP_LOGW(TAG, "audio stream not terminated properly before");
-    else audio_stream_ringbuf = xRingbufferCreate(AUDIO_BUF_LEN, RINGBUF_TYPE_BYTEBUF);
+    else audio_stream_ringbuf = xRingbufferCreate(profile->ring_frames * CONCEAL_FRAME_SIZE, RINGBUF_TYPE_BYTEBUF);
 
     if(audio_stream_ringbuf)
     {
@@ -518,6 +830,9 @@ static bool tasks_audio_stream_prepare()
 
                 if(dsp_fft_buf_create())
                 {
+                    limiter_reset();
+                    conceal_reset();
+                    trimmed_bytes = 0;
                     ach_player_start();
                     ret = true;
                     ESP_LOGI(TAG, "audio stream prepared");
@@ -547,6 +862,7 @@ static bool tasks_audio_stream_prepare()
 
 static void tasks_audio_stream_terminate()
 {
+    ESP_LOGI(TAG, "trimmed bytes in the stream: %d", trimmed_bytes);
     vRingbufferDelete(audio_stream_ringbuf);
     audio_stream_ringbuf = NULL;
     ach_player_stop();
@@ -564,6 +880,11 @@ static void tasks_audio_stream_terminate()
         xSemaphoreGive(dsp_in_semaphore);
     }
     else PRINT_TRACE();
+
+    /* profile selected while audio stream was on */
+    tasks_audio_profile_apply();
+    /* FFT result deleted, the lights render the still frame */
+    tasks_lights_wake();
 }
 
 static void tasks_signal_send(tasks_signal signal)
@@ -577,29 +898,132 @@ static void tasks_signal_send(tasks_signal signal)
     //     default: ERR_BAD_CASE(signal.type, "%d");
     // }
 
-    switch(signal.aim_task)
+    if((signal.aim_task >= TASKS_INST_MAX) || (signal.type >= TASKS_SIG_MAX) || !mailboxes[signal.aim_task].task)
     {
-        case TASKS_INST_AUDIO_PLAYER:
-            ERR_CHECK(pdTRUE != xQueueSend(mails_audio_player, &signal, pdMS_TO_TICKS(10)));
-            break;
-        case TASKS_INST_AUDIO_DSP:
-        case TASKS_INST_LIGHT:
-        case TASKS_INST_HOTSPOT:
-        default:
-            ESP_LOGE(TAGE, "signal task: %d, signal type: %d", signal.aim_task, signal.type);
-            PRINT_TRACE();
+        ESP_LOGE(TAGE, "signal task: %d, signal type: %d", signal.aim_task, signal.type);
+        PRINT_TRACE();
+        return;
     }
+
+    tasks_mailbox *mailbox = &mailboxes[signal.aim_task];
+
+    /* argument slot keeps only the latest value,
+     * the same pending signal type sent again is coalesced */
+    taskENTER_CRITICAL(&mailbox->lock);
+    mailbox->args[signal.type] = signal.arg;
+    mailbox->seqs[signal.type] = ++mailbox->seq;
+    taskEXIT_CRITICAL(&mailbox->lock);
+
+    /* setting bits never blocks and never fails */
+    xTaskNotifyIndexed(mailbox->task, TASKS_NOTIFY_MAIL, (1UL << signal.type), eSetBits);
+}
+
+static uint8_t tasks_mail_receive(tasks_instance task, TickType_t tick, tasks_signal *signals)
+{
+    uint32_t bits = 0;
+    uint32_t seqs[TASKS_SIG_MAX];
+    uint8_t signal_n = 0;
+
+    if(pdTRUE != xTaskNotifyWaitIndexed(TASKS_NOTIFY_MAIL, 0, UINT32_MAX, &bits, tick)) return 0;
+
+    tasks_mailbox *mailbox = &mailboxes[task];
+    taskENTER_CRITICAL(&mailbox->lock);
+
+    for(uint8_t type = 0; type < TASKS_SIG_MAX; type++)
+    {
+        if(!(bits & (1UL << type))) continue;
+
+        signals[signal_n] = (tasks_signal) {
+            .aim_task = task,
+            .type = type,
+            .arg = mailbox->args[type]
+        };
+        seqs[signal_n] = mailbox->seqs[type];
+        signal_n++;
+    }
+
+    taskEXIT_CRITICAL(&mailbox->lock);
+
+    /* insertion sort by the sequence number to keep the sending order,
+     * e.g. stream suspend and start have to be processed in order */
+    for(uint8_t i = 1; i < signal_n; i++)
+    {
+        tasks_signal signal = signals[i];
+        uint32_t seq = seqs[i];
+        uint8_t j = i;
+
+        for(; (j > 0) && ((int32_t)(seqs[j - 1] - seq) > 0); j--)
+        {
+            signals[j] = signals[j - 1];
+            seqs[j] = seqs[j - 1];
+        }
+
+        signals[j] = signal;
+        seqs[j] = seq;
+    }
+
+    return signal_n;
 }
 
+#if TASKS_MAIL_BENCHMARK_ENABLE
+static void tasks_mail_benchmark()
+{
+    /* per message cost (send + receive) of the previously used
+     * FreeRTOS queue mailbox and the task notification mailbox,
+     * measured once in the calling task at startup */
+    tasks_signal signal = {
+        .aim_task = TASKS_INST_UNKNOWN,
+        .type = TASKS_SIG_AUDIO_VOLUME
+    };
+    tasks_signal signals[TASKS_SIG_MAX];
+    QueueHandle_t queue = xQueueCreate(1, sizeof(tasks_signal));
+    ERR_IF_NULL_RETURN(queue);
+    uint32_t start = esp_cpu_get_cycle_count();
+
+    for(uint8_t i = 0; i < TASKS_MAIL_BENCHMARK_N; i++)
+    {
+        xQueueSend(queue, &signal, 0);
+        xQueueReceive(queue, &signal, 0);
+    }
+
+    uint32_t queue_cycles = (esp_cpu_get_cycle_count() - start) / TASKS_MAIL_BENCHMARK_N;
+    vQueueDelete(queue);
+    /* temporary mailbox of the calling task */
+    mailboxes[TASKS_INST_UNKNOWN].task = xTaskGetCurrentTaskHandle();
+    start = esp_cpu_get_cycle_count();
+
+    for(uint8_t i = 0; i < TASKS_MAIL_BENCHMARK_N; i++)
+    {
+        tasks_signal_send(signal);
+        tasks_mail_receive(TASKS_INST_UNKNOWN, 0, signals);
+    }
+
+    uint32_t notify_cycles = (esp_cpu_get_cycle_count() - start) / TASKS_MAIL_BENCHMARK_N;
+    mailboxes[TASKS_INST_UNKNOWN].task = NULL;
+    ESP_LOGI(TAG, "message cost, queue: %ld cycles, task notification: %ld cycles", queue_cycles, notify_cycles);
+}
+#endif
+
 static void tasks_dsp()
 {
     ESP_LOGI(TAG, "dsp started");
     TickType_t lastWakeTime;
+    int64_t start_time, end_time;
+    bool missed;
 
     ESP_LOGI(TAG, "dsp enter infinite loop");
     while(1)
     {
+        /* no audio stream, nothing to do until tasks_audio_state wakes up */
+        if(audio_state < AUDIO_STATE_READY)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            profiler_loop_idle(PROFILER_LOOP_DSP);
+        }
+
         lastWakeTime = xTaskGetTickCount();
+        start_time = esp_timer_get_time();
+        trace_event(TRACE_DSP_BEGIN, 0);
 
         /* DSP buffers only available from at least READY audio state */
         if(audio_state >= AUDIO_STATE_READY)
@@ -614,6 +1038,8 @@ static void tasks_dsp()
                 if(pdTRUE == xSemaphoreTake(dsp_out_semaphore, portMAX_DELAY))
                 {
                     dsp_fft_finalize();
+                    /* still in the semaphore, the next lights_main uses this result */
+                    latency_reached(LATENCY_STAGE_DSP);
                     xSemaphoreGive(dsp_out_semaphore);
                 }
                 else PRINT_TRACE();
@@ -621,16 +1047,10 @@ static void tasks_dsp()
             else PRINT_TRACE();
         }
 
-        if(pdTRUE != xTaskDelayUntil(&lastWakeTime, TASKS_DSP_MIN_TIME)) rip_sum++;
-
-        rip_count++;
-
-        if(999 < rip_count)
-        {
-            ESP_LOGW(TAG, LOG_COLOR_W"DSP skipped %d tick under %d times", rip_sum, rip_count);
-            rip_count = 0;
-            rip_sum = 0;
-        }
+        trace_event(TRACE_DSP_END, 0);
+        end_time = esp_timer_get_time();
+        missed = pdTRUE != xTaskDelayUntil(&lastWakeTime, TASKS_DSP_MIN_TIME);
+        profiler_loop(PROFILER_LOOP_DSP, start_time, end_time, missed);
     }
 }
 
@@ -638,27 +1058,52 @@ static void tasks_lights()
 {
     ESP_LOGI(TAG, "lights started");
     TickType_t lastWakeTime;
-    tasks_signal signal;
+    tasks_signal signals[TASKS_SIG_MAX];
+    uint8_t signal_n;
+    int64_t start_time, end_time;
+    bool missed;
+    /* idle: the strips would not change without a config change or audio stream */
+    bool animated = true;
+    bool busy = false;
+    bool idle = false;
+    tasks_pm_hold(pm_lock_lights, true);
 
     ESP_LOGI(TAG, "lights enter infinite loop");
     while(1)
     {
+        /* sleeping until any mail (TASKS_SIG_LIGHTS_WAKE or config save) */
+        signal_n = tasks_mail_receive(TASKS_INST_LIGHT, idle ? portMAX_DELAY : 0, signals);
+
+        if(idle)
+        {
+            idle = false;
+            tasks_pm_hold(pm_lock_lights, true);
+            profiler_loop_idle(PROFILER_LOOP_LIGHTS);
+        }
+
         lastWakeTime = xTaskGetTickCount();
+        start_time = esp_timer_get_time();
+        trace_event(TRACE_LIGHTS_BEGIN, 0);
 
         if(pdTRUE == xSemaphoreTake(lights_semaphore, portMAX_DELAY))
         {
-            signal = (tasks_signal) {.type = TASKS_SIG_UNKNOWN, .aim_task = TASKS_INST_UNKNOWN};
-
-            if(pdTRUE == xQueueReceive(mails_lights, &signal, 0))
+            for(uint8_t i = 0; i < signal_n; i++)
             {
-                if(signal.type == TASKS_SIG_CONFIG_LIGHTS_SAVE) storage_save_lights();
-                else ERR_BAD_CASE(signal.type, "%d");
+                if(signals[i].type == TASKS_SIG_CONFIG_LIGHTS_SAVE) storage_save_lights();
+                else if(signals[i].type == TASKS_SIG_CONFIG_AUDIO_SAVE) storage_save_audio_profile(signals[i].arg.audio_profile.id);
+                else if(signals[i].type == TASKS_SIG_LIGHTS_WAKE) continue;
+                else ERR_BAD_CASE(signals[i].type, "%d");
+
+                tasks_throttled_acknowledge(TASKS_INST_LIGHT, signals[i].type);
             }
 
             /* take the DSP out semaphore for safely read consistent FFT result */
             if(pdTRUE == xSemaphoreTake(dsp_out_semaphore, portMAX_DELAY))
             {
-                lights_main();
+                INSTR_BEGIN(INSTR_LIGHTS_MAIN);
+                animated = lights_main();
+                busy = lights_busy();
+                INSTR_END(INSTR_LIGHTS_MAIN);
                 xSemaphoreGive(dsp_out_semaphore);
             }
             else PRINT_TRACE();
@@ -667,17 +1112,49 @@ static void tasks_lights()
         }
         else PRINT_TRACE();
 
-        xTaskDelayUntil(&lastWakeTime, TASKS_LIGHTS_MIN_TIME);
+        trace_event(TRACE_LIGHTS_END, 0);
+        end_time = esp_timer_get_time();
+        missed = pdTRUE != xTaskDelayUntil(&lastWakeTime, TASKS_LIGHTS_MIN_TIME);
+        profiler_loop(PROFILER_LOOP_LIGHTS, start_time, end_time, missed);
+
+        /* FFT zones animated only by a live audio stream,
+         * a frame waiting for its strip or the dithering goes on without it */
+        if((!animated || (audio_state < AUDIO_STATE_READY)) && !busy)
+        {
+            idle = true;
+            tasks_pm_hold(pm_lock_lights, false);
+        }
     }
 }
 
+static void tasks_pm_hold(esp_pm_lock_handle_t lock, bool hold)
+{
+#if CONFIG_PM_ENABLE
+    if(!lock) return;
+
+    if(hold) ERR_CHECK(esp_pm_lock_acquire(lock));
+    else ERR_CHECK(esp_pm_lock_release(lock));
+#endif
+}
+
+static void tasks_lights_wake()
+{
+    /* config parsed at boot before the lights task exists */
+    if(!mailboxes[TASKS_INST_LIGHT].task) return;
+
+    tasks_signal signal = {
+        .aim_task = TASKS_INST_LIGHT,
+        .type = TASKS_SIG_LIGHTS_WAKE
+    };
+    tasks_message(signal);
+}
+
 // static void throttled_signal_dumb(tasks_signal_throttled *signal)
 // {
 //     printf("signal dump\n");
 //     switch(signal->waiting_signal.aim_task)
 //     {
 //         case TASKS_INST_UNKNOWN: printf("task: UNKNOWN\n"); break;
-//         case TASKS_INST_THROTTLER: printf("task: THROTTLER\n"); break;
 //         case TASKS_INST_AUDIO_PLAYER: printf("task: AUDIO_PLAYER\n"); break;
 //         case TASKS_INST_AUDIO_DSP: printf("task: AUDIO_DSP\n"); break;
 //         case TASKS_INST_LIGHT: printf("task: LIGHT\n"); break;
@@ -693,9 +1170,9 @@ static void tasks_lights()
 //         case TASKS_SIG_AUDIO_VOLUME: printf("type: AUDIO_VOLUME\n"); break;
 //         default: printf("type has invalid value\n");
 //     }
-//     printf("tick left: %ld\n", signal->tick_left);
+//     printf("min time: %ldus\n", signal->min_time_us);
 //     printf("live: %d\n", signal->live);
-//     printf("started: %d\n", signal->started);
+//     printf("expired: %d\n", signal->expired);
 //     printf("need send: %d\n", signal->need_send);
 //     printf("need acknowledge: %d\n\n", signal->need_acknowledge);
 // }
@@ -9,16 +9,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
 
+#include "audio_profile.h"
 
-#define TASKS_THROTTLE_MIN_TIME pdMS_TO_TICKS(100)
+
+/* min time between two delivered signals of the same type,
+ * signals coming meanwhile coalesced, only the last one delivered */
+#define TASKS_THROTTLE_VOLUME_MS 200
+#define TASKS_THROTTLE_CONFIG_SAVE_MS 1000
+/* throttled signal statistic logged after this many delivered signals */
+#define TASKS_THROTTLE_LOG_N 50
+/* task notification index of the mailbox signal bits,
+ * index 0 is free for the task's own use (e.g. I2S DMA sent events) */
+#define TASKS_NOTIFY_MAIL 1
+/* message count of the startup mailbox cost measurement (TASKS_MAIL_BENCHMARK_ENABLE) */
+#define TASKS_MAIL_BENCHMARK_N 100
 #define TASKS_DSP_MIN_TIME pdMS_TO_TICKS(10)
 #define TASKS_LIGHTS_MIN_TIME pdMS_TO_TICKS(10)
 
 
 typedef enum {
     TASKS_INST_UNKNOWN,
-    TASKS_INST_THROTTLER,
     TASKS_INST_AUDIO_PLAYER,
     TASKS_INST_AUDIO_DSP,
     TASKS_INST_LIGHT,
@@ -32,7 +44,10 @@ typedef enum {
     TASKS_SIG_AUDIO_STREAM_SUSPEND,
     TASKS_SIG_AUDIO_DATA_SUFFICIENT,
     TASKS_SIG_AUDIO_VOLUME,
+    TASKS_SIG_AUDIO_PROFILE,
     TASKS_SIG_CONFIG_LIGHTS_SAVE,
+    TASKS_SIG_CONFIG_AUDIO_SAVE,
+    TASKS_SIG_LIGHTS_WAKE,
     TASKS_SIG_MAX
 } tasks_signal_type;
 
@@ -40,6 +55,9 @@ typedef union {
     union {
         uint8_t volume;
     } audio_volume;
+    union {
+        audio_profile_id id;
+    } audio_profile;
 } tasks_signal_arg;
 
 typedef struct {
@@ -48,19 +66,46 @@ typedef struct {
     tasks_signal_arg arg;
 } tasks_signal;
 
+/* every signal type is one bit in the task's notification value,
+ * its argument is kept in the slot, sequence numbers keep the order,
+ * the lock is per receiver: producers of other tasks never contend */
+typedef struct {
+    TaskHandle_t task;
+    portMUX_TYPE lock; // a few instructions held, never blocks the producer
+    uint32_t seq;
+    uint32_t seqs[TASKS_SIG_MAX];
+    tasks_signal_arg args[TASKS_SIG_MAX];
+} tasks_mailbox;
+
 typedef struct {
     tasks_signal waiting_signal;
-    TickType_t tick_left;
-    bool live;
-    bool started;
+    esp_timer_handle_t timer; // one-shot, runs for min_time_us after a delivery
+    uint32_t min_time_us;
+    int64_t waiting_since; // time of the first coalesced signal
+    int64_t latency_us; // latency of the actually delivered signal
+    bool live; // throttling on, signals have to wait
+    bool expired; // min time ellapsed, but previous signal not acknowledged
     bool need_send;
     bool need_acknowledge;
+    /* statistic */
+    uint32_t stat_sent;
+    uint32_t stat_coalesced;
+    int64_t stat_latency_sum;
+    int64_t stat_latency_max;
 } tasks_signal_throttled;
 
 
 void tasks_create();
 void tasks_message(tasks_signal signal);
 void tasks_audio_data(const uint8_t *data, size_t size);
+/* output latency [us] of the next incoming audio packet,
+ * false if audio not playing */
+bool tasks_audio_latency(uint32_t *latency_us);
+/* buffering profile applied immediately if audio stream off,
+ * else after the audio stream ended,
+ * save: stored to config.json once the audio player applied it */
+void tasks_audio_profile_select(audio_profile_id id, bool save);
+void tasks_audio_profile(audio_profile_id *selected, audio_profile_id *active);
 bool tasks_lights_lock();
 void tasks_lights_release();
 
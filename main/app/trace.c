@@ -0,0 +1,64 @@
+
+#include "stdlib.h"
+#include "string.h"
+#include "stdatomic.h"
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#include "app_tools.h"
+#include "trace.h"
+
+
+static const char *TAGE = LOG_COLOR("36") "TRACE" LOG_COLOR_E;
+#if TRACE_ENABLE
+/* writers reserve a slot with one atomic increment, so they never wait
+ * each other, a record being written while the snapshot copies it
+ * may come out torn (acceptable for a diagnostic) */
+static trace_record ring[TRACE_RECORD_N] = {0};
+static atomic_uint_fast32_t head = 0; // count of all records ever written
+#endif
+
+
+#if TRACE_ENABLE
+void IRAM_ATTR trace_event(trace_event_id event, uint16_t arg)
+{
+    uint32_t i = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed) % TRACE_RECORD_N;
+    trace_record *record = &ring[i];
+    record->time_us = (uint32_t)esp_timer_get_time();
+    record->event = event;
+    record->core = xPortGetCoreID();
+    record->arg = arg;
+}
+#endif
+
+uint8_t *trace_snapshot(size_t *len)
+{
+    uint32_t record_n = 0;
+#if TRACE_ENABLE
+    uint32_t end = atomic_load_explicit(&head, memory_order_relaxed);
+    record_n = (end < TRACE_RECORD_N) ? end : TRACE_RECORD_N;
+#endif
+    size_t buf_len = 4 + 4 + record_n * sizeof(trace_record);
+    uint8_t *buf = (uint8_t*)malloc(buf_len);
+    ERR_IF_NULL_RETURN_VAL(buf, NULL);
+    uint32_t magic = TRACE_MAGIC;
+    memcpy(buf, &magic, 4);
+    memcpy(&buf[4], &record_n, 4);
+
+#if TRACE_ENABLE
+    /* the oldest record is at end in a full ring */
+    uint8_t *p = &buf[8];
+    uint32_t start = (end - record_n) % TRACE_RECORD_N;
+    uint32_t part_n = TRACE_RECORD_N - start;
+
+    if(part_n > record_n) part_n = record_n;
+
+    memcpy(p, &ring[start], part_n * sizeof(trace_record));
+    memcpy(p + part_n * sizeof(trace_record), ring, (record_n - part_n) * sizeof(trace_record));
+#endif
+
+    *len = buf_len;
+    return buf;
+}
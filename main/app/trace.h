@@ -0,0 +1,52 @@
+/*
+ * Binary event trace ring (post-mortem timing analysis)
+ */
+
+#ifndef __APP_TRACE_H__
+#define __APP_TRACE_H__
+
+
+#include "stdint.h"
+#include "stddef.h"
+
+#include "app_config.h"
+
+
+/* "TRC1" little endian, at the start of the snapshot */
+#define TRACE_MAGIC 0x31435254
+
+
+typedef enum {
+    TRACE_AUDIO_STATE, // arg: new audio_state_t
+    TRACE_RING_FILL, // arg: audio ringbuf waiting bytes
+    TRACE_CONCEAL, // arg: 0 overflow trim, 1 underrun fill
+    TRACE_DSP_BEGIN,
+    TRACE_DSP_END,
+    TRACE_LIGHTS_BEGIN,
+    TRACE_LIGHTS_END,
+    TRACE_RMT_DONE, // arg: strip index
+    TRACE_MAX
+} trace_event_id;
+
+/* one record, 8 bytes */
+typedef struct {
+    uint32_t time_us; // esp_timer, wraps after ~71 minutes
+    uint8_t event; // trace_event_id
+    uint8_t core;
+    uint16_t arg;
+} trace_record;
+
+
+#if TRACE_ENABLE
+/* lock-free, callable from ISR too */
+void trace_event(trace_event_id event, uint16_t arg);
+#else
+#define trace_event(event, arg) do {} while(0)
+#endif
+/* copy of the ring from the oldest to the newest record after a header:
+ * magic (uint32) + record_n (uint32) + record_n * trace_record,
+ * the returned buffer has to be freed, NULL on error */
+uint8_t *trace_snapshot(size_t *len);
+
+
+#endif /* __APP_TRACE_H__ */
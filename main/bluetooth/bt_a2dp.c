@@ -1,13 +1,18 @@
 
+#include "stdlib.h"
+
 #include "esp_a2dp_api.h"
 
+#include "app_config.h"
 #include "app_tools.h"
 #include "bt_profiles.h"
 #include "tasks.h"
+#include "instr.h"
 
 
 static void a2dp_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param);
 static void a2dp_data_callback(const uint8_t *data, uint32_t len);
+static void a2dp_delay_report();
 
 
 static const char *TAG = LOG_COLOR("94") "BT_A2DP";
@@ -17,6 +22,10 @@ static uint32_t audio_packet_cnt = 0;
 static uint32_t audio_packet_min = UINT32_MAX;
 static uint32_t audio_packet_max = 0;
 static uint32_t audio_packet_sum = 0;
+/* delay reporting, only used from Bluetooth stack context */
+static bool delay_rpt_enabled = false;
+static uint32_t delay_avg_us = 0; // 0: no sample yet
+static uint16_t delay_reported = 0; // unit: 1/10 ms
 
 
 void bt_a2dp_init()
@@ -70,6 +79,7 @@ static void a2dp_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
                 audio_packet_min = UINT32_MAX;
                 audio_packet_max = 0;
                 audio_packet_sum = 0;
+                delay_avg_us = 0;
                 signal.type = TASKS_SIG_AUDIO_STREAM_STARTED;
             }
             else
@@ -98,7 +108,7 @@ static void a2dp_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
 
                 ESP_LOGI(TAG, "SBC media codec capabilities: 0x %X %X %X %X", sbc[0], sbc[1], sbc[2], sbc[3]);
 
-                if(sample_rate != 44100)
+                if(sample_rate != AUDIO_SAMPLE_RATE)
                 {
                     ESP_LOGE(TAGE, "NOT SUPPORTED sample rate: %d", sample_rate);
                 }
@@ -130,14 +140,35 @@ static void a2dp_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
             if(param->a2d_psc_cfg_stat.psc_mask & ESP_A2D_PSC_DELAY_RPT)
             {
                 ESP_LOGI(TAG, "peer device support delay reporting");
+                delay_rpt_enabled = true;
+                delay_reported = 0;
             }
             else
             {
                 ESP_LOGI(TAG, "peer device unsupport delay reporting");
+                delay_rpt_enabled = false;
+            }
+
+            break;
+        }
+        /* when the delay value set (and reported to the source), this event comes */
+        case ESP_A2D_SNK_SET_DELAY_VALUE_EVT: {
+            if(param->a2d_set_delay_value_stat.set_state == ESP_A2D_SET_SUCCESS)
+            {
+                ESP_LOGI(TAG, "delay reported: %d.%dms",
+                    param->a2d_set_delay_value_stat.delay_value / 10, param->a2d_set_delay_value_stat.delay_value % 10);
+            }
+            else
+            {
+                ESP_LOGE(TAGE, "delay report fail: %d", param->a2d_set_delay_value_stat.delay_value);
             }
 
             break;
         }
+        case ESP_A2D_SNK_GET_DELAY_VALUE_EVT: {
+            ESP_LOGI(TAG, "delay value: %d", param->a2d_get_delay_value_stat.delay_value);
+            break;
+        }
         default:
             ERR_BAD_CASE(event, "%d");
     }
@@ -145,11 +176,16 @@ static void a2dp_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *param)
 
 static void a2dp_data_callback(const uint8_t *data, uint32_t len)
 {
+    INSTR_BEGIN(INSTR_AUDIO_DATA);
     tasks_audio_data(data, len);
+    INSTR_END(INSTR_AUDIO_DATA);
+
     if(len < audio_packet_min) audio_packet_min = len;
     if(len > audio_packet_max) audio_packet_max = len;
     audio_packet_sum += len;
 
+    if(delay_rpt_enabled) a2dp_delay_report();
+
     /* log the number every 100 packets */
     if(++audio_packet_cnt % 100 == 0)
     {
@@ -159,3 +195,28 @@ static void a2dp_data_callback(const uint8_t *data, uint32_t len)
         audio_packet_sum = 0;
     }
 }
+
+static void a2dp_delay_report()
+{
+    uint32_t latency_us;
+
+    if(!tasks_audio_latency(&latency_us)) return;
+
+    /* the ringbuf fill saw-tooths with the packets, so it is averaged
+     * (exponential moving average with 1/8 weight) */
+    if(!delay_avg_us) delay_avg_us = latency_us;
+    else delay_avg_us = ((delay_avg_us * 7) + latency_us) / 8;
+
+    if(audio_packet_cnt % A2DP_DELAY_CHECK_PACKET_N) return;
+
+    /* A2DP delay unit is 1/10 ms */
+    uint32_t delay = delay_avg_us / 100;
+
+    if(delay > UINT16_MAX) delay = UINT16_MAX;
+
+    if(abs((int32_t)delay - delay_reported) > (A2DP_DELAY_THRESHOLD_MS * 10))
+    {
+        if(ESP_OK == esp_a2d_sink_set_delay_value(delay)) delay_reported = delay;
+        else PRINT_TRACE();
+    }
+}
@@ -8,6 +8,16 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+
+typedef struct {
+    uint32_t refill_n; // measured refills
+    uint32_t latency_avg; // from a DMA buffer sent out to its refill [us]
+    uint32_t latency_max; // [us]
+    int32_t slack_min; // time left at the refill before the DMA runs empty [us], INT32_MAX without refill
+} ach_refill_stat;
 
 
 void ach_control_init();
@@ -15,10 +25,21 @@ void ach_volume(uint8_t vol);
 void ach_unmute();
 void ach_mute();
 
-void ach_player_init(uint32_t *total_dma_buf_size);
+/* dma_buf_frames: frames in one I2S DMA buffer
+ * sent_notify task gets a notification (give) each time
+ * an I2S DMA buffer sent out and ready to refill
+ * false if the I2S channel can't created (e.g. not enough DMA memory) */
+bool ach_player_init(uint8_t dma_buf_n, uint32_t dma_buf_frames, TaskHandle_t sent_notify);
+/* release the I2S channel, it has to be stopped before */
+void ach_player_deinit();
 void ach_player_start();
 void ach_player_stop();
 void ach_player_data(const void *src, size_t size);
+/* call it after the sent out DMA buffers refilled,
+ * measure: false if the refill not caused by a sent out buffer */
+void ach_player_refilled(bool measure);
+/* refill timing since the previous reset */
+void ach_player_refill_stat(ach_refill_stat *stat, bool reset);
 
 
 #endif /* __AUDIO_CODEC_HANDLER_H__ */
@@ -1,6 +1,7 @@
 
 #include "driver/i2s_std.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
 
 #include "app_config.h"
 #include "app_tools.h"
@@ -10,23 +11,38 @@
 static const char *TAG = LOG_COLOR("95") "CODEC" LOG_RESET_COLOR;
 static const char *TAGE = LOG_COLOR("95") "CODEC" LOG_COLOR_E;
 static i2s_chan_handle_t tx_chan = NULL;
+/* I2S DMA buffer number and play out time of one buffer */
+static uint8_t dma_buf_num = 0;
+static int32_t dma_buf_us = 0;
+/* time [us] of the first sent out DMA buffer which still waiting refill,
+ * 32 bit to be atomic between ISR and task (wrapping difference is still valid) */
+static volatile uint32_t sent_time = 0;
+/* refill statistic, read by the profiler */
+static portMUX_TYPE refill_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t refill_cnt = 0; // locked with refill_lock
+static uint64_t refill_latency_sum = 0; // locked with refill_lock
+static uint32_t refill_latency_max = 0; // locked with refill_lock
+static int32_t refill_slack_min = INT32_MAX; // locked with refill_lock
 
 
-void ach_player_init(uint32_t *total_dma_buf_size)
+static bool ach_player_sent_callback(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+
+
+bool ach_player_init(uint8_t dma_buf_n, uint32_t dma_buf_frames, TaskHandle_t sent_notify)
 {
     i2s_chan_config_t chan_cfg = {
         .id = I2S_PERIPH_NUM,
         .role = I2S_ROLE_MASTER,
-        .dma_desc_num = I2S_DMA_BUF_N,
-        .dma_frame_num = I2S_DMA_BUF_SIZE,
+        .dma_desc_num = dma_buf_n,
+        .dma_frame_num = dma_buf_frames,
         .auto_clear = true
     };
 
-    ERR_CHECK_RESET(i2s_new_channel(&chan_cfg, &tx_chan, NULL));
+    ERR_CHECK_RETURN_VAL(i2s_new_channel(&chan_cfg, &tx_chan, NULL), false);
 
     i2s_std_config_t std_cfg = {
         .clk_cfg = {
-            .sample_rate_hz = 44100,
+            .sample_rate_hz = AUDIO_SAMPLE_RATE,
             /* technical reference: the analog PLL output clock source APLL_CLK
                must be used to acquire highly accurate I2Sn_CLK and BCK */
             .clk_src = I2S_CLK_SRC_APLL,
@@ -47,14 +63,36 @@ void ach_player_init(uint32_t *total_dma_buf_size)
         }
     };
 
-    ERR_CHECK_RESET(i2s_channel_init_std_mode(tx_chan, &std_cfg));
+    /* DMA buffers allocated here, profile change may not fit into memory */
+    if(ESP_OK != i2s_channel_init_std_mode(tx_chan, &std_cfg))
+    {
+        ESP_LOGE(TAGE, "I2S channel init fail, DMA buffers: %d * %ld frames", dma_buf_n, dma_buf_frames);
+        ach_player_deinit();
+        return false;
+    }
+
     ERR_CHECK_RESET(gpio_set_drive_capability(PIN_I2S_BCLK, GPIO_DRIVE_CAP_0));
     ERR_CHECK_RESET(gpio_set_drive_capability(PIN_I2S_WS, GPIO_DRIVE_CAP_0));
     ERR_CHECK_RESET(gpio_set_drive_capability(PIN_I2S_DOUT, GPIO_DRIVE_CAP_0));
+    i2s_event_callbacks_t callbacks = {
+        .on_sent = ach_player_sent_callback
+    };
+    ERR_CHECK_RESET(i2s_channel_register_event_callback(tx_chan, &callbacks, sent_notify));
     i2s_chan_info_t info;
     i2s_channel_get_info(tx_chan, &info);
     ESP_LOGI(TAG, "I2S channel init OK with buf size: %ld", info.total_dma_buf_size);
-    *total_dma_buf_size = info.total_dma_buf_size;
+    dma_buf_num = dma_buf_n;
+    dma_buf_us = (dma_buf_frames * 1000000LL) / AUDIO_SAMPLE_RATE;
+    sent_time = 0;
+    return true;
+}
+
+void ach_player_deinit()
+{
+    if(!tx_chan) return;
+
+    ERR_CHECK(i2s_del_channel(tx_chan));
+    tx_chan = NULL;
 }
 
 void ach_player_data(const void *src, size_t size)
@@ -68,6 +106,46 @@ void ach_player_data(const void *src, size_t size)
     }
 }
 
+void ach_player_refilled(bool measure)
+{
+    uint32_t sent = sent_time;
+    sent_time = 0;
+
+    if(!measure || !sent) return;
+
+    /* after a buffer sent out, the remaining queued buffers
+     * give the deadline for the refill before the DMA runs empty */
+    uint32_t latency = (uint32_t)esp_timer_get_time() - sent;
+    int32_t slack = (dma_buf_us * (dma_buf_num - 1)) - (int32_t)latency;
+    taskENTER_CRITICAL(&refill_lock);
+    refill_cnt++;
+    refill_latency_sum += latency;
+
+    if(latency > refill_latency_max) refill_latency_max = latency;
+    if(slack < refill_slack_min) refill_slack_min = slack;
+
+    taskEXIT_CRITICAL(&refill_lock);
+}
+
+void ach_player_refill_stat(ach_refill_stat *stat, bool reset)
+{
+    taskENTER_CRITICAL(&refill_lock);
+    stat->refill_n = refill_cnt;
+    stat->latency_avg = refill_cnt ? (refill_latency_sum / refill_cnt) : 0;
+    stat->latency_max = refill_latency_max;
+    stat->slack_min = refill_slack_min;
+
+    if(reset)
+    {
+        refill_cnt = 0;
+        refill_latency_sum = 0;
+        refill_latency_max = 0;
+        refill_slack_min = INT32_MAX;
+    }
+
+    taskEXIT_CRITICAL(&refill_lock);
+}
+
 void ach_player_start()
 {
     ESP_LOGW(TAG, "I2S channel STARTED");
@@ -81,3 +159,14 @@ void ach_player_stop()
     i2s_channel_disable(tx_chan);
     ach_mute();
 }
+
+static bool IRAM_ATTR ach_player_sent_callback(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    BaseType_t need_yield = pdFALSE;
+
+    /* zero means no waiting buffer, so skip it as a time value */
+    if(!sent_time) sent_time = (uint32_t)esp_timer_get_time() | 1;
+
+    vTaskNotifyGiveFromISR((TaskHandle_t)user_ctx, &need_yield);
+    return need_yield == pdTRUE;
+}
@@ -29,12 +29,19 @@ typedef enum {
     WEB_WS_CID_STRIP_CFG,
     WEB_WS_CID_ZONE_CFG,
     WEB_WS_CID_SHADER_CFG,
+    WEB_WS_CID_AUDIO_METER,
+    WEB_WS_CID_AUDIO_PROFILE,
+    WEB_WS_CID_PROFILER,
+    WEB_WS_CID_INSTR_DUMP,
 } web_ws_id_clientbound;
 
 typedef enum {
     WEB_WS_SID_STRIP_SET,
     WEB_WS_SID_ZONE_SET,
     WEB_WS_SID_SHADER_SET,
+    WEB_WS_SID_AUDIO_METER_GET,
+    WEB_WS_SID_AUDIO_PROFILE_SET,
+    WEB_WS_SID_INSTR_DUMP,
 } web_ws_id_serverbound;
 
 
@@ -43,9 +50,17 @@ void web_server_stop();
 esp_err_t web_redirect(httpd_req_t *req, httpd_err_code_t err);
 esp_err_t web_file_content(httpd_req_t *req);
 esp_err_t web_unsafe_file_content(httpd_req_t *req);
+/* event trace snapshot download (binary, see trace.h) */
+esp_err_t web_trace_content(httpd_req_t *req);
+/* audio capture start (/capture/start) and download (binary, see capture.h) */
+esp_err_t web_capture_content(httpd_req_t *req);
 esp_err_t web_ws(httpd_req_t *req);
 void web_ws_send(int sockfd, uint8_t *payload, size_t len);
+/* payload sent to every websocket client, freed after */
 void web_ws_send_all(uint8_t *payload, size_t len);
+/* periodic profiler statistic push to every websocket client */
+void web_ws_profiler_start();
+void web_ws_profiler_stop();
 
 
 extern httpd_handle_t web_server_hd;
@@ -5,6 +5,7 @@
 #include "esp_log.h"
 #include "socket.h"
 
+#include "app_config.h"
 #include "app_tools.h"
 #include "web.h"
 
@@ -22,7 +23,7 @@ void web_server_start()
     ESP_LOGI(TAG, "HTTP server starting...");
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.core_id = 1;
+    config.core_id = TASKS_CORE_HTTP_SERVER;
     config.stack_size = 3136;
     config.lru_purge_enable = true;
     config.max_open_sockets = HTTPD_MAX_SOCKETS;
@@ -30,7 +31,7 @@ void web_server_start()
     config.send_wait_timeout = 1;
     config.backlog_conn = 3;
     config.max_resp_headers = 1;
-    config.max_uri_handlers = 3;
+    config.max_uri_handlers = 5;
 
     /* Use the URI wildcard matching function in order to
      * allow the same handler to respond to multiple different
@@ -53,6 +54,20 @@ void web_server_start()
     };
     ESP_ERROR_CHECK(httpd_register_uri_handler(web_server_hd, &ws_handler));
 
+    httpd_uri_t trace_handler = {
+        .uri = "/trace",
+        .method = HTTP_GET,
+        .handler = web_trace_content
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(web_server_hd, &trace_handler));
+
+    httpd_uri_t capture_handler = {
+        .uri = "/capture*",
+        .method = HTTP_GET,
+        .handler = web_capture_content
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(web_server_hd, &capture_handler));
+
     httpd_uri_t unsafe_content_handler = {
         .uri = "/spiffs/*",
         .method = HTTP_GET,
@@ -68,6 +83,7 @@ void web_server_start()
     ESP_ERROR_CHECK(httpd_register_uri_handler(web_server_hd, &content_handler));
 
     ESP_ERROR_CHECK(httpd_register_err_handler(web_server_hd, HTTPD_405_METHOD_NOT_ALLOWED, web_redirect));
+    web_ws_profiler_start();
     ESP_LOGI(TAG, "HTTP server started OK");
 }
 
@@ -75,6 +91,7 @@ void web_server_stop()
 {
     if(web_server_hd)
     {
+        web_ws_profiler_stop();
         httpd_stop(web_server_hd);
         web_server_hd = NULL;
     }
@@ -5,6 +5,8 @@
 #include "app_tools.h"
 #include "web.h"
 #include "file_system.h"
+#include "trace.h"
+#include "capture.h"
 
 
 static esp_err_t web_set_content_type(httpd_req_t *req, const char *filename);
@@ -49,6 +51,54 @@ esp_err_t web_unsafe_file_content(httpd_req_t *req)
     return web_serve_file(req, filename, req->uri);
 }
 
+esp_err_t web_trace_content(httpd_req_t *req)
+{
+    size_t len;
+    uint8_t *trace = trace_snapshot(&len);
+
+    if(!trace)
+    {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "trace sending (%d bytes)...", len);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"trace.bin\"");
+    esp_err_t err = httpd_resp_send(req, (const char*)trace, len);
+    free(trace);
+    return err;
+}
+
+esp_err_t web_capture_content(httpd_req_t *req)
+{
+    if(!strcmp(req->uri, "/capture/start"))
+    {
+        httpd_resp_set_type(req, "text/plain");
+
+        if(capture_start()) return httpd_resp_sendstr(req, "capture started");
+
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+        return ESP_FAIL;
+    }
+
+    size_t len;
+    uint8_t *capture = capture_take(&len);
+
+    if(!capture)
+    {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "nothing captured, start it at /capture/start");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "capture sending (%d bytes)...", len);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"capture.bin\"");
+    esp_err_t err = httpd_resp_send(req, (const char*)capture, len);
+    free(capture);
+    return err;
+}
+
 /* set HTTP response content type according to file extension */
 static esp_err_t web_set_content_type(httpd_req_t *req, const char *filename)
 {
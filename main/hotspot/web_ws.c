@@ -1,22 +1,40 @@
 
 #include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "app_tools.h"
 #include "app_config.h"
 #include "web.h"
 #include "lights.h"
+#include "limiter.h"
+#include "audio_profile.h"
+#include "tasks.h"
+#include "profiler.h"
+#include "instr.h"
+#include "latency.h"
 
 
+/* a line of the strip transmit counters in the instrumentation dump */
+#define WEB_WS_TX_STAT_LINE_SIZE 64
+
+
+static esp_err_t web_ws_send_frame(int sockfd, uint8_t *payload, size_t len);
 static void web_ws_send_done_callback(esp_err_t err, int socketfd, void *arg);
+static void web_ws_profiler_callback(void *arg);
 static void web_ws_process_msg(httpd_req_t *req, httpd_ws_frame_t frame);
 static void web_ws_send_strips(int sockfd);
 static void web_ws_send_zones(int sockfd);
 static void web_ws_send_shader(lights_zone_chain *zone, uint8_t strip_index, uint8_t zone_index, int sockfd);
+static void web_ws_send_audio_meter(int sockfd);
+static void web_ws_send_audio_profile(int sockfd);
+static void web_ws_send_instr_dump(int sockfd);
 
 
 static const char *TAG = LOG_COLOR("96") "web_ws" LOG_RESET_COLOR;
 static const char *TAGE = LOG_COLOR("96") "web_ws" LOG_COLOR_E;
+/* periodic profiler push, runs while the web server runs */
+static esp_timer_handle_t profiler_timer = NULL;
 
 
 esp_err_t web_ws(httpd_req_t *req)
@@ -42,6 +60,7 @@ esp_err_t web_ws(httpd_req_t *req)
             }
         }
 
+        web_ws_send_audio_profile(sockfd);
         return ESP_OK;
     }
 
@@ -72,6 +91,57 @@ esp_err_t web_ws(httpd_req_t *req)
 }
 
 void web_ws_send(int sockfd, uint8_t *payload, size_t len)
+{
+    printf("WS_TX_%d[%d] = ", sockfd, len);
+    PRINT_ARRAY_HEX(payload, len);
+    web_ws_send_frame(sockfd, payload, len);
+}
+
+void web_ws_send_all(uint8_t *payload, size_t len)
+{
+    /* every client gets its own copy, because the payload freed after sent */
+    size_t fd_n = HTTPD_MAX_SOCKETS;
+    int fds[HTTPD_MAX_SOCKETS];
+
+    if(!web_server_hd || (ESP_OK != httpd_get_client_list(web_server_hd, &fd_n, fds))) fd_n = 0;
+
+    for(size_t i = 0; i < fd_n; i++)
+    {
+        if(HTTPD_WS_CLIENT_WEBSOCKET != httpd_ws_get_fd_info(web_server_hd, fds[i])) continue;
+
+        uint8_t *copy = (uint8_t*)malloc(len);
+        ERR_IF_NULL(copy);
+
+        if(!copy) break;
+
+        memcpy(copy, payload, len);
+        web_ws_send_frame(fds[i], copy, len);
+    }
+
+    free(payload);
+}
+
+void web_ws_profiler_start()
+{
+    if(!profiler_timer)
+    {
+        esp_timer_create_args_t timer_args = {
+            .callback = web_ws_profiler_callback,
+            .name = "profiler"
+        };
+        ERR_CHECK_RETURN(ESP_OK != esp_timer_create(&timer_args, &profiler_timer));
+    }
+
+    ERR_CHECK(ESP_OK != esp_timer_start_periodic(profiler_timer, PROFILER_PUSH_MS * 1000));
+}
+
+void web_ws_profiler_stop()
+{
+    if(profiler_timer) esp_timer_stop(profiler_timer);
+}
+
+/* payload freed after sent (or failed), no log of the frame content */
+static esp_err_t web_ws_send_frame(int sockfd, uint8_t *payload, size_t len)
 {
     httpd_ws_frame_t frame = {
         .payload = payload,
@@ -79,15 +149,17 @@ void web_ws_send(int sockfd, uint8_t *payload, size_t len)
         .type = HTTPD_WS_TYPE_BINARY
     };
 
-    printf("WS_TX_%d[%d] = ", sockfd, len);
-    PRINT_ARRAY_HEX(payload, len);
+    esp_err_t err = httpd_ws_send_data_async(web_server_hd, sockfd, &frame, web_ws_send_done_callback, frame.payload);
 
-    httpd_ws_send_data_async(web_server_hd, sockfd, &frame, web_ws_send_done_callback, frame.payload);
+    /* not queued, so the callback will not free it */
+    if(ESP_OK != err) free(payload);
+
+    return err;
 }
 
 static void web_ws_send_done_callback(esp_err_t err, int socketfd, void *arg)
 {
-    /* arg is the frame payload cames from web_ws_send() */
+    /* arg is the frame payload cames from web_ws_send_frame() */
     if(err != ESP_OK)
     {
         ESP_LOGE(TAGE, "send done callback socket_%d error: %s", socketfd, esp_err_to_name(err));
@@ -98,8 +170,12 @@ static void web_ws_send_done_callback(esp_err_t err, int socketfd, void *arg)
 
 static void web_ws_process_msg(httpd_req_t *req, httpd_ws_frame_t frame)
 {
-    printf("WS_RX_%d[%d] = ", httpd_req_to_sockfd(req), frame.len);
-    PRINT_ARRAY_HEX(frame.payload, frame.len);
+    /* the audio meter polled, not hex dumped */
+    if(frame.payload[0] != WEB_WS_SID_AUDIO_METER_GET)
+    {
+        printf("WS_RX_%d[%d] = ", httpd_req_to_sockfd(req), frame.len);
+        PRINT_ARRAY_HEX(frame.payload, frame.len);
+    }
 
     switch(frame.payload[0])
     {
@@ -109,31 +185,50 @@ static void web_ws_process_msg(httpd_req_t *req, httpd_ws_frame_t frame)
         //     break;
         // case WEB_WS_SID_SHADER_SET:
         //     break;
+        case WEB_WS_SID_AUDIO_METER_GET:
+            web_ws_send_audio_meter(httpd_req_to_sockfd(req));
+            break;
+        case WEB_WS_SID_AUDIO_PROFILE_SET:
+            /* SID + profile id */
+            if((frame.len == 2) && (frame.payload[1] < AUDIO_PROFILE_MAX))
+            {
+                /* stored by the lights task after the audio player applied it */
+                tasks_audio_profile_select(frame.payload[1], true);
+            }
+            else ESP_LOGE(TAGE, "invalid audio profile message");
+
+            web_ws_send_audio_profile(httpd_req_to_sockfd(req));
+            break;
+        case WEB_WS_SID_INSTR_DUMP:
+            web_ws_send_instr_dump(httpd_req_to_sockfd(req));
+            break;
         default: ESP_LOGE(TAGE, "unknown WS message");
     }
 }
 
 static void web_ws_send_strips(int sockfd)
 {
-    /* CID + strip_n * (pixel_n + rgb_order) */
-    size_t len = 1 + sizeof(size_t) + MLED_STRIP_N * (sizeof(size_t) + 3);
+    /* CID + strip_n * (pixel_n + rgb_order), the order zero padded without white */
+    size_t len = 1 + sizeof(size_t) + MLED_STRIP_N * (sizeof(size_t) + MLED_PIXEL_SIZE_MAX);
     uint8_t *payload = (uint8_t*)calloc(1, len);
     ERR_IF_NULL_RETURN(payload);
     uint8_t *p = payload;
     *p++ = WEB_WS_CID_STRIP_CFG;
-    size_t *p_size;
     mled_rgb_order rgb_order;
 
     for(uint8_t i = 0; i < MLED_STRIP_N; i++)
     {
-        p_size = (size_t*)p;
-        *p_size++ = mled_channels[i].pixels.pixel_n;
-        p = (uint8_t*)p_size;
+        /* not aligned after the CID, so copy bytewise */
+        memcpy(p, &mled_channels[i].pixels.pixel_n, sizeof(size_t));
+        p += sizeof(size_t);
         rgb_order = mled_channels[i].rgb_order;
         p[rgb_order.i_r] = 'R';
         p[rgb_order.i_g] = 'G';
         p[rgb_order.i_b] = 'B';
-        p += 3;
+
+        if(rgb_order.white) p[rgb_order.i_w] = 'W';
+
+        p += MLED_PIXEL_SIZE_MAX;
     }
 
     ESP_LOGW(TAG, "send strips payload bytes: %d (check: %d)", len, (p - payload));
@@ -155,16 +250,16 @@ static void web_ws_send_zones(int sockfd)
         uint8_t *p = payload;
         *p++ = WEB_WS_CID_ZONE_CFG;
         *p++ = i;
-        size_t *p_size = (size_t*)p;
         lights_zone_chain *zone = list->first;
 
+        /* not aligned after the CID and the strip index, so copy bytewise */
         while(zone)
         {
-            *p_size++ = zone->frame_buf.pixel_n;
+            memcpy(p, &zone->frame_buf.pixel_n, sizeof(size_t));
+            p += sizeof(size_t);
             zone = zone->next;
         }
 
-        p = (uint8_t*)p_size;
         ESP_LOGW(TAG, "send zones payload bytes: %d (check: %d)", len, (p - payload));
         web_ws_send(sockfd, payload, len);
     }
@@ -251,9 +346,8 @@ static void web_ws_send_shader(lights_zone_chain *zone, uint8_t strip_index, uin
 
             p = (uint8_t*)p_float;
             *p++ = cfg->is_right;
-            p_float = (float*)p;
-            *p_float++ = cfg->intensity;
-            p = (uint8_t*)p_float;
+            memcpy(p, &cfg->intensity, sizeof(float));
+            p += sizeof(float);
             *p++ = cfg->mirror;
             break;
         }
@@ -264,3 +358,83 @@ static void web_ws_send_shader(lights_zone_chain *zone, uint8_t strip_index, uin
     ESP_LOGW(TAG, "send zones shader bytes: %d (check: %d)", len, (p - payload));
     web_ws_send(sockfd, payload, len);
 }
+
+static void web_ws_send_audio_meter(int sockfd)
+{
+    /* CID + limiter gain reduction (current + max since last request) */
+    size_t len = 1 + 2 * sizeof(float);
+    uint8_t *payload = (uint8_t*)calloc(1, len);
+    ERR_IF_NULL_RETURN(payload);
+    float meter[2];
+    limiter_get_reduction(&meter[0], &meter[1]);
+    payload[0] = WEB_WS_CID_AUDIO_METER;
+    /* floats are not aligned after the CID, so copy bytewise */
+    memcpy(&payload[1], meter, sizeof(meter));
+    /* polled by the page twice a second, not hex dumped to the UART */
+    web_ws_send_frame(sockfd, payload, len);
+}
+
+static void web_ws_send_audio_profile(int sockfd)
+{
+    /* CID + selected + active + profile_n * zero ended name */
+    size_t len = 1 + 1 + 1;
+    audio_profile_id selected, active;
+    tasks_audio_profile(&selected, &active);
+
+    for(uint8_t i = 0; i < AUDIO_PROFILE_MAX; i++)
+    {
+        len += strlen(audio_profile_get(i)->name) + 1;
+    }
+
+    uint8_t *payload = (uint8_t*)calloc(1, len);
+    ERR_IF_NULL_RETURN(payload);
+    uint8_t *p = payload;
+    *p++ = WEB_WS_CID_AUDIO_PROFILE;
+    *p++ = selected;
+    *p++ = active;
+
+    for(uint8_t i = 0; i < AUDIO_PROFILE_MAX; i++)
+    {
+        const char *name = audio_profile_get(i)->name;
+        strcpy((char*)p, name);
+        p += strlen(name) + 1;
+    }
+
+    web_ws_send(sockfd, payload, len);
+}
+
+static void web_ws_send_instr_dump(int sockfd)
+{
+    /* CID + text (not zero ended), the statistics cleared after the dump */
+    size_t size = 1 + INSTR_DUMP_SIZE + LATENCY_DUMP_SIZE + (MLED_STRIP_N * WEB_WS_TX_STAT_LINE_SIZE);
+    uint8_t *payload = (uint8_t*)malloc(size);
+    ERR_IF_NULL_RETURN(payload);
+    payload[0] = WEB_WS_CID_INSTR_DUMP;
+    size_t len = instr_dump((char*)&payload[1], INSTR_DUMP_SIZE, true);
+    len += latency_dump((char*)&payload[1 + len], LATENCY_DUMP_SIZE, true);
+    lights_tx_stat tx_stat;
+    int line;
+
+    for(uint8_t i = 0; i < MLED_STRIP_N; i++)
+    {
+        lights_get_tx_stat(i, &tx_stat, true);
+        line = snprintf((char*)&payload[1 + len], WEB_WS_TX_STAT_LINE_SIZE, "strip %d: frames sent %lu, unchanged skipped %lu\n",
+            i, (unsigned long)tx_stat.sent, (unsigned long)tx_stat.skipped);
+
+        /* snprintf returns the wanted length, a long line is cut to the buffer */
+        if(line > 0) len += (line < WEB_WS_TX_STAT_LINE_SIZE) ? line : (WEB_WS_TX_STAT_LINE_SIZE - 1);
+    }
+
+    ESP_LOGI(TAG, "%s", (char*)&payload[1]);
+    web_ws_send_frame(sockfd, payload, 1 + len);
+}
+
+static void web_ws_profiler_callback(void *arg)
+{
+    /* CID + profiler sample (layout in profiler.c) */
+    size_t len;
+    uint8_t *payload = profiler_sample(1, &len);
+    ERR_IF_NULL_RETURN(payload);
+    payload[0] = WEB_WS_CID_PROFILER;
+    web_ws_send_all(payload, len);
+}
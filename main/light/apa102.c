@@ -0,0 +1,103 @@
+
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+
+#include "app_tools.h"
+#include "led_matrix.h"
+#include "trace.h"
+#include "latency.h"
+
+
+/* the SPI hosts free for the strips, SPI1 is the flash */
+#define APA102_HOST_N 2
+
+
+static void mled_apa102_done_callback(spi_transaction_t *trans);
+
+
+static const char *TAG = LOG_COLOR("96") "APA102" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("96") "APA102" LOG_COLOR_E;
+static const spi_host_device_t apa102_hosts[APA102_HOST_N] = {SPI2_HOST, SPI3_HOST};
+static size_t apa102_host_n = 0;
+static spi_device_handle_t apa102_devs[MLED_STRIP_N] = {0};
+/* the queued transaction has to live until its result taken */
+static spi_transaction_t apa102_trans[MLED_STRIP_N] = {0};
+static bool apa102_queued[MLED_STRIP_N] = {0};
+
+
+void mled_init_apa102(mled_strip *strip, gpio_num_t data_pin, gpio_num_t clk_pin)
+{
+    size_t index = strip - mled_channels;
+    ERR_CHECK_RESET(MLED_STRIP_N <= index);
+    ERR_CHECK_RESET(APA102_HOST_N <= apa102_host_n);
+    spi_host_device_t host = apa102_hosts[apa102_host_n++];
+    spi_bus_config_t bus_config = {
+        .mosi_io_num = data_pin,
+        .miso_io_num = -1,
+        .sclk_io_num = clk_pin,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = MLED_APA102_HEAD_SIZE + (MLED_APA102_PIXEL_N_MAX * MLED_APA102_PIXEL_SIZE) + MLED_APA102_TAIL_SIZE(MLED_APA102_PIXEL_N_MAX)
+    };
+    ERR_CHECK_RESET(spi_bus_initialize(host, &bus_config, SPI_DMA_CH_AUTO));
+    /* only MOSI and clock, data sampled on the rising edge */
+    spi_device_interface_config_t dev_config = {
+        .mode = 0,
+        .clock_speed_hz = MLED_APA102_CLOCK_HZ,
+        .spics_io_num = -1,
+        .queue_size = 1,
+        .post_cb = mled_apa102_done_callback
+    };
+    ERR_CHECK_RESET(spi_bus_add_device(host, &dev_config, &apa102_devs[index]));
+    strip->type = MLED_TYPE_APA102;
+    strip->tx_busy = false;
+    /* B, G, R on the wire */
+    strip->rgb_order = (mled_rgb_order) {.i_r = 2, .i_g = 1, .i_b = 0};
+    ESP_LOGI(TAG, "init strip %d on SPI%d, data GPIO %d, clock GPIO %d OK", index, host + 1, data_pin, clk_pin);
+}
+
+void mled_wait_apa102(mled_strip *strip)
+{
+    size_t index = strip - mled_channels;
+    spi_transaction_t *done;
+
+    if(!apa102_queued[index]) return;
+
+    ERR_CHECK(ESP_OK != spi_device_get_trans_result(apa102_devs[index], &done, portMAX_DELAY));
+    apa102_queued[index] = false;
+}
+
+bool mled_send_apa102(mled_strip *strip)
+{
+    size_t index = strip - mled_channels;
+    mled_pixels *pixels = &strip->pixels;
+    spi_transaction_t *trans = &apa102_trans[index];
+
+    if(strip->tx_busy) return false;
+
+    /* done already, only its result taken */
+    mled_wait_apa102(strip);
+    /* the DMA reads the frame buffer with the start and end frame around the pixels */
+    *trans = (spi_transaction_t) {
+        .length = pixels->frame_size * 8,
+        .tx_buffer = pixels->data - pixels->head_size,
+        .user = (void*)index
+    };
+    strip->tx_busy = true;
+
+    esp_err_t err = spi_device_queue_trans(apa102_devs[index], trans, 0);
+
+    if(ESP_OK != err) strip->tx_busy = false;
+
+    ERR_CHECK_RETURN_VAL(ESP_OK != err, false);
+    apa102_queued[index] = true;
+    return true;
+}
+
+static void IRAM_ATTR mled_apa102_done_callback(spi_transaction_t *trans)
+{
+    /* user is the strip index */
+    mled_channels[(size_t)trans->user].tx_busy = false;
+    trace_event(TRACE_RMT_DONE, (size_t)trans->user);
+    latency_reached(LATENCY_STAGE_TX);
+}
@@ -5,6 +5,7 @@
 
 
 static float color_fn(color_hsl hsl, float a, float n);
+static inline uint8_t color_fix_fn(int32_t lum, int32_t a, int32_t k);
 
 /* implementation of:
  * https://en.wikipedia.org/wiki/HSL_and_HSV#HSL_to_RGB_alternative */
@@ -24,3 +25,56 @@ static float color_fn(color_hsl hsl, float a, float n)
     float k = fmodf((n + (hsl.hue / 30.0f)), 12.0f);
     return hsl.lum - (a * fmaxf(-1.0f, fminf((k - 3.0f), fminf((9 - k), 1.0f))));
 }
+
+color_hsl_fix color_hsl_to_fix(color_hsl hsl)
+{
+    int32_t hue = lrintf(hsl.hue * (COLOR_HUE_FIX_N / 360.0f)) % COLOR_HUE_FIX_N;
+
+    if(hue < 0) hue += COLOR_HUE_FIX_N;
+
+    color_hsl_fix fix = {
+        .hue = hue,
+        .sat = lrintf(fminf(fmaxf(hsl.sat, 0), 1.0f) * COLOR_FIX_ONE),
+        .lum = lrintf(fminf(fmaxf(hsl.lum, 0), 1.0f) * COLOR_FIX_ONE)
+    };
+    return fix;
+}
+
+/* same formula as color_hsl_to_rgb, the k offsets in 1/256 sectors */
+color_rgb color_hsl_fix_to_rgb(color_hsl_fix hsl)
+{
+    int32_t lum = hsl.lum;
+    int32_t min_lum = (lum < (COLOR_FIX_ONE - lum)) ? lum : (COLOR_FIX_ONE - lum);
+    int32_t a = ((hsl.sat * min_lum) + (COLOR_FIX_ONE / 2)) / COLOR_FIX_ONE;
+    color_rgb rgb = {
+        .r = color_fix_fn(lum, a, hsl.hue),
+        .g = color_fix_fn(lum, a, hsl.hue + (8 * 256)),
+        .b = color_fix_fn(lum, a, hsl.hue + (4 * 256))
+    };
+    return rgb;
+}
+
+void color_hsl_fix_to_rgb_n(const color_hsl_fix *hsl, color_rgb *rgb, size_t n)
+{
+    while(n--)
+    {
+        *rgb++ = color_hsl_fix_to_rgb(*hsl++);
+    }
+}
+
+/* lum, a: 1.0 is COLOR_FIX_ONE, k: [0..2 * COLOR_HUE_FIX_N) */
+static inline uint8_t color_fix_fn(int32_t lum, int32_t a, int32_t k)
+{
+    if(k >= COLOR_HUE_FIX_N) k -= COLOR_HUE_FIX_N;
+
+    /* trapezoid of k in [-1..1] (256 is 1.0) */
+    int32_t t = k - (3 * 256);
+
+    if(t > ((9 * 256) - k)) t = (9 * 256) - k;
+    if(t > 256) t = 256;
+    else if(t < -256) t = -256;
+
+    /* value in 1.0 = COLOR_FIX_ONE * 256, never negative as a <= min(lum, 1 - lum) */
+    int32_t value = (lum * 256) - (a * t);
+    return ((value * 255) + (COLOR_FIX_ONE * 128)) / (COLOR_FIX_ONE * 256);
+}
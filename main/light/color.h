@@ -7,6 +7,13 @@
 
 
 #include <stdint.h>
+#include <stddef.h>
+
+
+/* fixed-point HSL: saturation and lightness 1.0,
+ * hue 360° (12 sectors of 30° by 256 steps) */
+#define COLOR_FIX_ONE 4096
+#define COLOR_HUE_FIX_N (12 * 256)
 
 
 typedef struct {
@@ -21,8 +28,20 @@ typedef struct {
     uint8_t b;
 } color_rgb;
 
+typedef struct {
+    uint16_t hue; // [0..COLOR_HUE_FIX_N)
+    uint16_t sat; // [0..COLOR_FIX_ONE]
+    uint16_t lum; // [0..COLOR_FIX_ONE]
+} color_hsl_fix;
+
 
+/* float reference */
 color_rgb color_hsl_to_rgb(color_hsl hsl);
+/* hue wrapped to the color wheel, saturation and lightness clamped */
+color_hsl_fix color_hsl_to_fix(color_hsl hsl);
+/* integer only, at most 1 off from color_hsl_to_rgb */
+color_rgb color_hsl_fix_to_rgb(color_hsl_fix hsl);
+void color_hsl_fix_to_rgb_n(const color_hsl_fix *hsl, color_rgb *rgb, size_t n);
 
 
 #endif /* __COLOR_H__ */
@@ -0,0 +1,225 @@
+
+#include "string.h"
+
+#include "app_config.h"
+#include "app_tools.h"
+#include "led_i2s.h"
+
+#if MLED_I2S_PARALLEL
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+#include "driver/i2s_types.h"
+#include "esp_private/i2s_platform.h"
+#include "soc/soc_caps.h"
+
+#include "trace.h"
+#include "latency.h"
+
+
+#if (MLED_STRIP_N != 8) && (MLED_STRIP_N != 16)
+#error "the I2S engine needs a strip on every data line, MLED_STRIP_N: 8 or 16"
+#endif
+
+#if SOC_LCD_I80_BUSES < 2
+#error "the I2S engine needs a second I2S, the audio output uses I2S_PERIPH_NUM"
+#endif
+
+
+static bool mled_i2s_done_callback(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
+
+
+static const char *TAG = LOG_COLOR("96") "MLED I2S" LOG_RESET_COLOR;
+static const char *TAGE = LOG_COLOR("96") "MLED I2S" LOG_COLOR_E;
+static esp_lcd_i80_bus_handle_t i2s_bus = NULL;
+static esp_lcd_panel_io_handle_t i2s_io = NULL;
+/* DMA buffer, the bus slots of MLED_I2S_PIXEL_N_MAX pixels (RGBW fits too) */
+static mled_i2s_slot *i2s_buf = NULL;
+/* the frame length: the longest strip */
+static size_t i2s_byte_n = 0;
+/* set by mled_i2s_send, cleared by the transmit done callback */
+static volatile bool i2s_busy = false;
+#endif
+
+
+void mled_i2s_transpose8(const uint8_t in[8], uint8_t out[8])
+{
+    /* Hacker's Delight 7-3 on two 32 bit halves, the lanes loaded in reverse
+     * that lane L lands on bit L of the planes */
+    uint32_t x = ((uint32_t)in[7] << 24) | ((uint32_t)in[6] << 16) | ((uint32_t)in[5] << 8) | in[4];
+    uint32_t y = ((uint32_t)in[3] << 24) | ((uint32_t)in[2] << 16) | ((uint32_t)in[1] << 8) | in[0];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = x >> 24;
+    out[1] = x >> 16;
+    out[2] = x >> 8;
+    out[3] = x;
+    out[4] = y >> 24;
+    out[5] = y >> 16;
+    out[6] = y >> 8;
+    out[7] = y;
+}
+
+void mled_i2s_frame_init(mled_i2s_slot *buf, size_t byte_n)
+{
+    /* the data slots and the reset code are zero */
+    memset(buf, 0, MLED_I2S_SLOT_N(byte_n) * sizeof(mled_i2s_slot));
+
+    /* every bit starts high on all lanes, the last slot stays low */
+    for(size_t i = 0; i < (byte_n * 8); i++)
+    {
+        buf[i * MLED_I2S_BIT_SLOT_N] = (mled_i2s_slot)~0;
+    }
+}
+
+void mled_i2s_encode(const mled_strip *strips, size_t strip_n, mled_i2s_slot *buf, size_t byte_n)
+{
+    uint8_t in[MLED_I2S_LANE_N] = {0};
+    uint8_t planes[MLED_I2S_LANE_N];
+    /* the two data slots of the first bit */
+    mled_i2s_slot *slot = &buf[1];
+    mled_i2s_slot plane;
+
+    if(strip_n > MLED_I2S_LANE_N) strip_n = MLED_I2S_LANE_N;
+
+    for(size_t byte_i = 0; byte_i < byte_n; byte_i++)
+    {
+        for(size_t lane = 0; lane < strip_n; lane++)
+        {
+            in[lane] = (byte_i < strips[lane].pixels.data_size) ? strips[lane].pixels.sent[byte_i] : 0;
+        }
+
+        mled_i2s_transpose8(in, planes);
+#if MLED_I2S_LANE_N == 16
+        mled_i2s_transpose8(&in[8], &planes[8]);
+#endif
+
+        for(uint8_t bit = 0; bit < 8; bit++)
+        {
+#if MLED_I2S_LANE_N == 16
+            plane = planes[bit] | ((mled_i2s_slot)planes[8 + bit] << 8);
+#else
+            plane = planes[bit];
+#endif
+            slot[0] = plane;
+            slot[1] = plane;
+            slot += MLED_I2S_BIT_SLOT_N;
+        }
+    }
+}
+
+#if MLED_I2S_PARALLEL
+void mled_i2s_init(const gpio_num_t *pins)
+{
+    ESP_LOGI(TAG, "init...");
+    size_t slot_n = MLED_I2S_SLOT_N(MLED_I2S_PIXEL_N_MAX * MLED_PIXEL_SIZE_MAX);
+    esp_lcd_i80_bus_config_t bus_config = {
+        .dc_gpio_num = MLED_I2S_PIN_DC,
+        .wr_gpio_num = MLED_I2S_PIN_WR,
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .bus_width = MLED_I2S_LANE_N,
+        .max_transfer_bytes = slot_n * sizeof(mled_i2s_slot),
+        .psram_trans_align = 4,
+        .sram_trans_align = 4
+    };
+
+    for(size_t i = 0; i < MLED_I2S_LANE_N; i++)
+    {
+        bus_config.data_gpio_nums[i] = pins[i];
+    }
+
+    /* esp_lcd takes the first free I2S: the audio one (I2S_PERIPH_NUM) held meanwhile
+     * if the audio player not created its channel yet, so the bus gets the other one */
+    bool audio_held = (ESP_OK == i2s_platform_acquire_occupation(I2S_PERIPH_NUM, "mled_i2s"));
+    ERR_CHECK_RESET(esp_lcd_new_i80_bus(&bus_config, &i2s_bus));
+
+    if(audio_held) ERR_CHECK_RESET(i2s_platform_release_occupation(I2S_PERIPH_NUM));
+
+    /* only data sent (no command phase), the DC pin stays low */
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = -1,
+        .pclk_hz = MLED_I2S_CLOCK_HZ,
+        .trans_queue_depth = 2,
+        .on_color_trans_done = mled_i2s_done_callback,
+        .user_ctx = NULL,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+        .dc_levels = {
+            .dc_idle_level = 0,
+            .dc_cmd_level = 0,
+            .dc_dummy_level = 0,
+            .dc_data_level = 0
+        }
+    };
+    ERR_CHECK_RESET(esp_lcd_new_panel_io_i80(i2s_bus, &io_config, &i2s_io));
+    i2s_buf = (mled_i2s_slot*)heap_caps_calloc(slot_n, sizeof(mled_i2s_slot), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ERR_IF_NULL_RESET(i2s_buf);
+    ESP_LOGI(TAG, "init %d lanes, DMA buf %d bytes OK", MLED_I2S_LANE_N, slot_n * sizeof(mled_i2s_slot));
+}
+
+bool mled_i2s_set_size(size_t byte_n)
+{
+    ERR_CHECK_RETURN_VAL((MLED_I2S_PIXEL_N_MAX * MLED_PIXEL_SIZE_MAX) < byte_n, false);
+    mled_i2s_wait();
+    mled_i2s_frame_init(i2s_buf, byte_n);
+    i2s_byte_n = byte_n;
+    return true;
+}
+
+bool mled_i2s_busy()
+{
+    return i2s_busy;
+}
+
+void mled_i2s_wait()
+{
+    /* a frame takes some ms, the DMA reads the buffer until its end */
+    while(i2s_busy)
+    {
+        vTaskDelay(1);
+    }
+}
+
+bool mled_i2s_send(const mled_strip *strips, size_t strip_n)
+{
+    if(i2s_busy) return false;
+
+    if(!i2s_byte_n) return true;
+
+    mled_i2s_encode(strips, strip_n, i2s_buf, i2s_byte_n);
+    i2s_busy = true;
+
+    esp_err_t err = esp_lcd_panel_io_tx_color(i2s_io, -1, i2s_buf, MLED_I2S_SLOT_N(i2s_byte_n) * sizeof(mled_i2s_slot));
+
+    if(ESP_OK != err) i2s_busy = false;
+
+    ERR_CHECK_RETURN_VAL(ESP_OK != err, false);
+    return true;
+}
+
+static bool IRAM_ATTR mled_i2s_done_callback(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    i2s_busy = false;
+
+    for(size_t i = 0; i < MLED_STRIP_N; i++)
+    {
+        trace_event(TRACE_RMT_DONE, i);
+    }
+
+    latency_reached(LATENCY_STAGE_TX);
+    return false;
+}
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Parallel matrix LED strip output with the I2S peripheral in LCD mode
+ */
+
+#ifndef __LED_I2S_H__
+#define __LED_I2S_H__
+
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#include "app_config.h"
+#include "led_matrix.h"
+
+
+/* a WS281x bit is 4 bus slots at 3.2 MHz: 1, data, data, 0
+ * so T0H: 312ns, T1H: 937ns, T1L: 312ns, bit time: 1.25µs */
+#define MLED_I2S_CLOCK_HZ 3200000
+#define MLED_I2S_BIT_SLOT_N 4
+#define MLED_I2S_BYTE_SLOT_N (8 * MLED_I2S_BIT_SLOT_N)
+/* WS281x reset code after the pixels, >280µs low */
+#define MLED_I2S_RESET_SLOT_N ((MLED_I2S_CLOCK_HZ / 1000000) * 300)
+/* bus slots of byte_n bytes on every strip, with the reset code */
+#define MLED_I2S_SLOT_N(byte_n) (((byte_n) * MLED_I2S_BYTE_SLOT_N) + MLED_I2S_RESET_SLOT_N)
+
+/* a bus slot has a bit of every strip (lane) */
+#if MLED_STRIP_N <= 8
+#define MLED_I2S_LANE_N 8
+typedef uint8_t mled_i2s_slot;
+#else
+#define MLED_I2S_LANE_N 16
+typedef uint16_t mled_i2s_slot;
+#endif
+
+
+/* 8 bytes to their 8 bit planes, MSB first: bit L of out[j] is bit (7 - j) of in[L] */
+void mled_i2s_transpose8(const uint8_t in[8], uint8_t out[8]);
+/* the constant slots of a frame with byte_n bytes per strip: buf has to fit MLED_I2S_SLOT_N(byte_n),
+ * needed only once per frame length, mled_i2s_encode writes only the data slots */
+void mled_i2s_frame_init(mled_i2s_slot *buf, size_t byte_n);
+/* the front buffers (sent) of the strips to bus slots, a shorter strip padded with zeros */
+void mled_i2s_encode(const mled_strip *strips, size_t strip_n, mled_i2s_slot *buf, size_t byte_n);
+
+#if MLED_I2S_PARALLEL
+void mled_i2s_init(const gpio_num_t *pins);
+/* the strip sizes changed, the frame length is the longest strip */
+bool mled_i2s_set_size(size_t byte_n);
+bool mled_i2s_busy();
+void mled_i2s_wait();
+/* encode and start the DMA, false if the last frame still transmitting */
+bool mled_i2s_send(const mled_strip *strips, size_t strip_n);
+#endif
+
+
+#endif /* __LED_I2S_H__ */
@@ -2,31 +2,52 @@
 #include "freertos/FreeRTOS.h"
 #include "driver/rmt_tx.h"
 #include "esp_clk_tree.h"
+#include "esp_heap_caps.h"
 #include "hal/clk_tree_hal.h"
 #include "soc/soc_caps.h"
 
 #include "app_config.h"
 #include "app_tools.h"
 #include "led_matrix.h"
+#include "led_i2s.h"
+#include "instr.h"
+#include "trace.h"
+#include "latency.h"
 
 
-#define RMT_MEM_SIZE (SOC_RMT_GROUPS * SOC_RMT_CHANNELS_PER_GROUP * SOC_RMT_MEM_WORDS_PER_CHANNEL)
-#define RMT_CHANNEL_MEM_SIZE (RMT_MEM_SIZE / MLED_STRIP_N)
+#define RMT_MEM_BLOCK_N (SOC_RMT_GROUPS * SOC_RMT_CHANNELS_PER_GROUP)
+#define RMT_TX_CHANNEL_N (SOC_RMT_GROUPS * SOC_RMT_TX_CANDIDATES_PER_GROUP)
 /* the mled_strip structure layout allows to the structure can obtained
  * by using the address of the first element of the structure,
  * which we have that is the rmt_encoder_t */
 #define GET_STRIP_FROM_BASE(encoder_base) (mled_strip*) encoder_base
 
+#if !MLED_I2S_PARALLEL && (MLED_STRIP_N > RMT_TX_CHANNEL_N)
+#error "MLED_STRIP_N more than the RMT TX channels"
+#endif
 
-static void mled_strip_init(size_t index, gpio_num_t pin);
+
+#if !MLED_I2S_PARALLEL
+static void mled_strip_init(size_t index, gpio_num_t pin, size_t mem_block_n);
+static bool mled_send_rmt(mled_strip *strip);
 static size_t mled_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state);
 static esp_err_t mled_encode_reset(rmt_encoder_t *encoder);
 static esp_err_t mled_encode_del(rmt_encoder_t *encoder);
+static bool mled_trans_done_callback(rmt_channel_handle_t tx_channel, const rmt_tx_done_event_data_t *edata, void *user_ctx);
+#endif
 
 
 static const char *TAG = LOG_COLOR("96") "MLED" LOG_RESET_COLOR;
 static const char *TAGE = LOG_COLOR("96") "MLED" LOG_COLOR_E;
 mled_strip mled_channels[MLED_STRIP_N] = {0};
+static const gpio_num_t mled_pins[MLED_STRIP_N] = MLED_STRIP_PINS;
+#if MLED_I2S_PARALLEL
+/* a strip swapped its buffers since the last send */
+static bool i2s_dirty = false;
+#else
+static const uint8_t mled_mem_blocks[MLED_STRIP_N] = MLED_STRIP_MEM_BLOCKS;
+static const gpio_num_t mled_clk_pins[MLED_STRIP_N] = MLED_STRIP_CLK_PINS;
+#endif
 
 
 void mled_init()
@@ -34,34 +55,140 @@ void mled_init()
     ESP_LOGI(TAG, "init...");
     /* APB can configured with other value, so need check this */
     ERR_CHECK_RESET(MLED_CLOCK_HZ != clk_hal_apb_get_freq_hz());
-    mled_strip_init(0, PIN_MLED_STRIP_0);
-    mled_strip_init(1, PIN_MLED_STRIP_1);
+#if MLED_I2S_PARALLEL
+    mled_i2s_init(mled_pins);
+
+    for(size_t i = 0; i < MLED_STRIP_N; i++)
+    {
+        mled_channels[i].tx_busy = false;
+        mled_channels[i].rgb_order = (mled_rgb_order) {.i_r = 0, .i_g = 1, .i_b = 2};
+    }
+#else
+    size_t mem_block_sum = 0;
+
+    for(size_t i = 0; i < MLED_STRIP_N; i++)
+    {
+        mem_block_sum += mled_mem_blocks[i];
+    }
+
+    ERR_CHECK_RESET(RMT_MEM_BLOCK_N < mem_block_sum);
+
+    for(size_t i = 0; i < MLED_STRIP_N; i++)
+    {
+        /* a strip with clock pin is a clocked strip */
+        if(GPIO_NUM_NC == mled_clk_pins[i]) mled_strip_init(i, mled_pins[i], mled_mem_blocks[i]);
+        else mled_init_apa102(&mled_channels[i], mled_pins[i], mled_clk_pins[i]);
+    }
+#endif
+
     ESP_LOGI(TAG, "init OK");
 }
 
 void mled_set_size(mled_strip *strip, size_t pixel_n)
 {
-    size_t mem_size = pixel_n * 3;
     mled_pixels *pixels = &strip->pixels;
+    size_t pixel_size = MLED_PIXEL_SIZE(strip->rgb_order);
+    size_t head_size = 0;
+    size_t tail_size = 0;
+    uint32_t caps = MALLOC_CAP_DEFAULT;
+
+    /* the DMA sends the clocked strips right from the buffers, the protocol frames around the pixels */
+    if(MLED_TYPE_APA102 == strip->type)
+    {
+        ERR_CHECK_RETURN(MLED_APA102_PIXEL_N_MAX < pixel_n);
+        pixel_size = MLED_APA102_PIXEL_SIZE;
+        head_size = MLED_APA102_HEAD_SIZE;
+        tail_size = MLED_APA102_TAIL_SIZE(pixel_n);
+        caps = MALLOC_CAP_DMA;
+    }
+
+    size_t data_size = pixel_n * pixel_size;
+    size_t mem_size = head_size + data_size + tail_size;
 
     if(pixels->data)
     {
         ESP_LOGW(TAG, "strip already has pixels buf, freeing %d...", pixels->pixel_n);
-        free(pixels->data);
+        /* the encoder may read the front buffer yet */
+#if MLED_I2S_PARALLEL
+        mled_i2s_wait();
+#else
+        if(MLED_TYPE_APA102 == strip->type) mled_wait_apa102(strip);
+        else ERR_CHECK(ESP_OK != rmt_tx_wait_all_done(strip->tx_channel, -1));
+#endif
+        free(pixels->data - pixels->head_size);
+        free(pixels->sent - pixels->head_size);
+        pixels->data = NULL;
+        pixels->sent = NULL;
         pixels->pixel_n = 0;
         pixels->data_size = 0;
+        pixels->head_size = 0;
+        pixels->frame_size = 0;
     }
 
-    pixels->data = (uint8_t*)calloc(1, mem_size);
+    /* zero: the start and end frames stay as allocated */
+    pixels->data = (uint8_t*)heap_caps_calloc(1, mem_size, caps);
     ERR_IF_NULL_RETURN(pixels->data);
-    pixels->data_size = mem_size;
+    pixels->sent = (uint8_t*)heap_caps_calloc(1, mem_size, caps);
+    ERR_IF_NULL_RETURN(pixels->sent);
+    pixels->data += head_size;
+    pixels->sent += head_size;
+    pixels->data_size = data_size;
     pixels->pixel_n = pixel_n;
+    pixels->head_size = head_size;
+    pixels->frame_size = mem_size;
+#if MLED_I2S_PARALLEL
+    /* every strip clocked until the longest ends */
+    size_t byte_n = 0;
+
+    for(size_t i = 0; i < MLED_STRIP_N; i++)
+    {
+        if(mled_channels[i].pixels.data_size > byte_n) byte_n = mled_channels[i].pixels.data_size;
+    }
+
+    ERR_CHECK_RETURN(!mled_i2s_set_size(byte_n));
+#endif
     ESP_LOGI(TAG, "set pixels buf size %d OK", pixel_n);
 }
 
-void mled_update(mled_strip *strip)
+bool mled_update(mled_strip *strip)
 {
     mled_pixels *pixels = &strip->pixels;
+    uint8_t *front;
+#if MLED_I2S_PARALLEL
+    /* the frame goes out by mled_flush with the other strips, the encode
+     * copies the front buffers, the DMA reads only its own buffer */
+    i2s_dirty = true;
+#else
+    bool sent;
+
+    if(MLED_TYPE_APA102 == strip->type) sent = mled_send_apa102(strip);
+    else sent = mled_send_rmt(strip);
+
+    if(!sent) return false;
+#endif
+
+    /* swap: the encoder reads the new front, the old front written next */
+    front = pixels->sent;
+    pixels->sent = pixels->data;
+    pixels->data = front;
+    return true;
+}
+
+bool mled_flush()
+{
+#if MLED_I2S_PARALLEL
+    if(i2s_dirty && mled_i2s_send(mled_channels, MLED_STRIP_N)) i2s_dirty = false;
+
+    return !i2s_dirty;
+#else
+    /* the RMT and SPI strips already sent by mled_update */
+    return true;
+#endif
+}
+
+#if !MLED_I2S_PARALLEL
+static bool mled_send_rmt(mled_strip *strip)
+{
     rmt_transmit_config_t tx_config = {
         .loop_count = 0,
         .flags = {
@@ -70,17 +197,28 @@ void mled_update(mled_strip *strip)
         }
     };
 
-    ERR_CHECK(rmt_transmit(strip->tx_channel, &strip->base, pixels->data, pixels->data_size, &tx_config));
+    /* the front buffer is free only after its transmit done */
+    if(strip->tx_busy) return false;
+
+    strip->tx_busy = true;
+
+    esp_err_t err = rmt_transmit(strip->tx_channel, &strip->base, strip->pixels.data, strip->pixels.data_size, &tx_config);
+
+    if(ESP_OK != err) strip->tx_busy = false;
+
+    ERR_CHECK_RETURN_VAL(ESP_OK != err, false);
+    return true;
 }
 
-static void mled_strip_init(size_t index, gpio_num_t pin)
+static void mled_strip_init(size_t index, gpio_num_t pin, size_t mem_block_n)
 {
     ERR_CHECK_RESET(MLED_STRIP_N <= index);
+    ERR_CHECK_RESET(!mem_block_n);
     mled_strip *strip = &mled_channels[index];
     rmt_tx_channel_config_t tx_chan_config = {
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .gpio_num = pin,
-        .mem_block_symbols = RMT_CHANNEL_MEM_SIZE,
+        .mem_block_symbols = mem_block_n * SOC_RMT_MEM_WORDS_PER_CHANNEL,
         .resolution_hz = MLED_CLOCK_HZ,
         .trans_queue_depth = 2,
     };
@@ -90,15 +228,22 @@ static void mled_strip_init(size_t index, gpio_num_t pin)
         .reset = mled_encode_reset,
         .del = mled_encode_del
     };
+    strip->type = MLED_TYPE_WS281X;
     strip->data_sent = false;
+    strip->tx_busy = false;
     mled_encode_chain_ws281x(strip);
+    rmt_tx_event_callbacks_t callbacks = {
+        .on_trans_done = mled_trans_done_callback
+    };
+    ERR_CHECK_RESET(rmt_tx_register_event_callbacks(strip->tx_channel, &callbacks, (void*)index));
     ERR_CHECK_RESET(rmt_enable(strip->tx_channel));
     strip->rgb_order = (mled_rgb_order) {.i_r = 0, .i_g = 1, .i_b = 2};
-    ESP_LOGI(TAG, "init strip %d as WS281x OK", index);
+    ESP_LOGI(TAG, "init strip %d as WS281x on GPIO %d, %d RMT blocks OK", index, pin, mem_block_n);
 }
 
 static size_t IRAM_ATTR mled_encode(rmt_encoder_t *encoder, rmt_channel_handle_t tx_channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
 {
+    INSTR_BEGIN(INSTR_MLED_ENCODE);
     mled_strip *strip = GET_STRIP_FROM_BASE(encoder);
     ERR_CHECK_RESET(strip->tx_channel != tx_channel);
     rmt_encoder_t *payload_handler = strip->payload_handler;
@@ -143,6 +288,7 @@ static size_t IRAM_ATTR mled_encode(rmt_encoder_t *encoder, rmt_channel_handle_t
     }
 
     *ret_state = state_own;
+    INSTR_END(INSTR_MLED_ENCODE);
     return byte_cnt;
 }
 
@@ -164,3 +310,13 @@ static esp_err_t mled_encode_del(rmt_encoder_t *encoder)
     ESP_LOGW(TAGE, "encoder deleted");
     return ESP_OK;
 }
+
+static bool IRAM_ATTR mled_trans_done_callback(rmt_channel_handle_t tx_channel, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    /* user_ctx is the strip index */
+    mled_channels[(size_t)user_ctx].tx_busy = false;
+    trace_event(TRACE_RMT_DONE, (size_t)user_ctx);
+    latency_reached(LATENCY_STAGE_TX);
+    return false;
+}
+#endif
@@ -7,7 +7,9 @@
 
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "stddef.h"
+#include "driver/gpio.h"
 #include "driver/rmt_encoder.h"
 
 #include "app_config.h"
@@ -16,18 +18,42 @@
 #define MLED_CLOCK_HZ 80000000
 #define MLED_US_TO_DURATION(us) ((MLED_CLOCK_HZ/1000000.0f)*us)
 #define MLED_NS_TO_DURATION(ns) ((MLED_CLOCK_HZ/1000000000.0f)*ns)
-
-
+/* clocked strip frame: 32 bit zero start, pixels: 0b111 + 5 bit brightness, B, G, R,
+ * then the end: 32 bit zero (SK9822 latch) and a clock per 2 pixel to push the data through */
+#define MLED_APA102_PIXEL_SIZE 4
+#define MLED_APA102_HEAD_SIZE 4
+#define MLED_APA102_TAIL_SIZE(pixel_n) (4 + ((pixel_n) / 16) + 1)
+#define MLED_APA102_HEADER 0xE0
+#define MLED_APA102_BRIGHTNESS_MAX 31
+/* bytes of a one wire strip pixel */
+#define MLED_PIXEL_SIZE(rgb_order) ((rgb_order).white ? 4 : 3)
+#define MLED_PIXEL_SIZE_MAX 4
+
+
+typedef enum {
+    MLED_TYPE_WS281X = 0, // one wire, RMT or the I2S engine
+    MLED_TYPE_APA102 // clocked (APA102, SK9822), SPI
+} mled_type;
+
+/* double buffered: the next frame written into data while
+ * the RMT encoder still reads the last one from sent */
 typedef struct {
-    uint8_t *data;
+    uint8_t *data; // back buffer, the next frame
+    uint8_t *sent; // front buffer, the last frame given to the RMT
     size_t data_size;
     size_t pixel_n;
+    size_t head_size; // protocol bytes before the pixels in both buffers (APA102 start frame)
+    size_t frame_size; // head, pixels and tail (APA102 end frame): the transmitted bytes
 } mled_pixels;
 
+/* pixel format of the strip: the channel byte offsets in a pixel on the wire,
+ * RGB in any order (WS2812: GRB) or with white (SK6812 RGBW: GRBW) */
 typedef struct {
     uint8_t i_r;
     uint8_t i_g;
     uint8_t i_b;
+    uint8_t i_w; // only with white
+    bool white; // 4 bytes a pixel, the output stage extracts the white
 } mled_rgb_order;
 
 typedef struct {
@@ -39,17 +65,38 @@ typedef struct {
     size_t reset_code_size;
     mled_pixels pixels;
     mled_rgb_order rgb_order;
+    mled_type type;
     bool data_sent;
+    volatile bool tx_busy; // RMT: set by mled_update, cleared by the transmit done callback
 } mled_strip;
 
 
 extern mled_strip mled_channels[MLED_STRIP_N];
+/* WS281x bit codes, MSB first */
+extern const rmt_bytes_encoder_config_t mled_ws281x_encoder_cfg;
 
 
 void mled_init();
 void mled_encode_chain_ws281x(mled_strip *strip);
+#if MLED_WS281X_LUT
+/* the symbols of every nibble value from the bit codes, mled_encode_chain_ws281x builds it */
+void mled_ws281x_lut_build();
+/* RMT simple encoder callback: the symbols of the whole data bytes which fit symbols_free,
+ * from the byte of symbols_written (a multiple of 8), done after the last byte */
+size_t mled_ws281x_encode(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free, rmt_symbol_word_t *symbols, bool *done, void *arg);
+#endif
+void mled_init_apa102(mled_strip *strip, gpio_num_t data_pin, gpio_num_t clk_pin);
+/* wait the transmit of a clocked strip, its buffers free after */
+void mled_wait_apa102(mled_strip *strip);
+/* start the transmit of the back buffer, false if the last frame still transmitting */
+bool mled_send_apa102(mled_strip *strip);
 void mled_set_size(mled_strip *strip, size_t pixel_n);
-void mled_update(mled_strip *strip);
+/* send the back buffer, then it becomes the front,
+ * false if the last frame still transmitting (nothing sent, the back buffer kept) */
+bool mled_update(mled_strip *strip);
+/* after the mled_update of the strips: the parallel engine sends them together,
+ * false if the last frame still transmitting (sent by a later call) */
+bool mled_flush();
 
 
 #endif /* __LED_MATRIX_H__ */
@@ -1,10 +1,28 @@
 
 #include "math.h"
+#include "string.h"
 #include "freertos/FreeRTOS.h"
 
 #include "app_tools.h"
 #include "lights.h"
 #include "dsp.h"
+#include "latency.h"
+
+
+/* 8 bit color to the 16 bit frame buffer, 255 is 65535 */
+#define LIGHTS_U8_TO_U16(x) ((uint16_t)((x) * 257))
+#define LIGHTS_GAMMA_LUT_N (1 << LIGHTS_GAMMA_LUT_BITS)
+/* dither offset step between the channels, ~golden ratio of 256,
+ * the neighbour channels get far dither values in the same frame */
+#define LIGHTS_DITHER_STEP 159
+/* frames of the bit reversed dither, every channel gets all the 256 dither values */
+#define LIGHTS_DITHER_CYCLE_N 256
+/* not a level, the pixel rendered next time surely */
+#define LIGHTS_FFT_LEVEL_NONE UINT8_MAX
+
+#if LIGHTS_FFT_LEVEL_N > LIGHTS_FFT_LEVEL_NONE
+#error "LIGHTS_FFT_LEVEL_N must fit uint8_t"
+#endif
 
 
 typedef enum {
@@ -19,11 +37,10 @@ typedef struct {
     fading_type type;
     union {
         struct {
-            uint8_t *buf;
-            mled_rgb_order offset;
+            uint16_t *buf;
         } shader_fade;
         struct {
-            color_hsl *lut_pos;
+            color_hsl_fix *lut_pos;
         } shader_fft;
     } ctx;
 } fading_ctx;
@@ -32,6 +49,9 @@ typedef struct {
 static const char *TAG = LOG_COLOR("95") "LIGHT" LOG_RESET_COLOR;
 static const char *TAGE = LOG_COLOR("95") "LIGHT" LOG_COLOR_E;
 lights_zone_list lights_zones[MLED_STRIP_N] = {0};
+/* 16 bit frame value (top bits) to the 8 bit output in 8.8 fixed point */
+static uint16_t gamma_lut[LIGHTS_GAMMA_LUT_N] = {0};
+static float gamma_cur = LIGHTS_GAMMA;
 
 
 static void lights_render_shader_color(lights_zone_chain *zone, bool *update_mled);
@@ -39,27 +59,35 @@ static void lights_render_shader_repeat(lights_zone_chain *zone, bool *update_ml
 static void lights_render_shader_fade(lights_zone_chain *zone, bool *update_mled);
 static void lights_render_shader_fft(lights_zone_chain *zone, bool *update_mled);
 static void fadeing(fading_ctx arg);
-static void fft_fadeing(lights_shader_cfg_fft *cfg, size_t pixel_n);
+static void fft_fadeing(lights_shader_cfg_fft *cfg, color_hsl_fix *pixel_lut, size_t pixel_n);
 static void fft_band_map(lights_zone_chain *zone);
+static bool fft_palette_bake(lights_shader_cfg_fft *cfg, size_t pixel_n);
+static uint8_t lights_dither_start(lights_zone_list *list);
+static bool lights_output_apa102(lights_zone_list *list, mled_strip *strip);
 
 
-void lights_main()
+bool lights_main()
 {
     mled_strip *strip;
+    lights_zone_list *list;
     lights_zone_chain *zone;
     bool update_mled;
+    bool rendered;
+    bool animated = false;
 
     for(uint8_t strip_index = 0; strip_index < MLED_STRIP_N; strip_index++)
     {
         strip = &mled_channels[strip_index];
         zone = lights_zones[strip_index].first;
         update_mled = false;
+        rendered = false;
 
         while(zone)
         {
             if(zone->shader.need_render)
             {
                 zone->shader.need_render = false;
+                rendered = true;
 
                 switch(zone->shader.type)
                 {
@@ -71,19 +99,100 @@ void lights_main()
                 }
             }
 
+            animated |= zone->shader.need_render;
             zone = zone->next;
         }
 
-        if(update_mled) mled_update(strip);
+        list = &lights_zones[strip_index];
+#if LIGHTS_DITHER
+        /* the fractions show up only as the average of the frames: a new dither
+         * pattern every loop for one cycle after the frame changed (also without
+         * a render), then the rounded frame held, a static frame lets the loop idle */
+        if(update_mled) list->dither_n = LIGHTS_DITHER_CYCLE_N + 1;
+        else update_mled = (list->dither_n > 0);
+
+        animated |= (list->dither_n > 0);
+#endif
+
+        /* a zone changed pixels (dirty), but the strip is sent only if the output changed too */
+        if(update_mled && lights_output(list, strip)) list->tx_pending = true;
+        else if(rendered && !list->tx_pending) list->tx_stat.skipped++;
+
+        if(list->tx_pending)
+        {
+            if(mled_update(strip))
+            {
+                list->tx_pending = false;
+                list->tx_stat.sent++;
+                latency_reached(LATENCY_STAGE_FRAME);
+            }
+            /* the last frame still transmitting, never waited,
+             * sent in the next loop (a newer frame may overwrite it until then) */
+            else animated = true;
+        }
     }
+
+    /* the parallel engine sends all the updated strips at once */
+    if(!mled_flush()) animated = true;
+
+    return animated;
+}
+
+bool lights_busy()
+{
+    for(uint8_t strip_index = 0; strip_index < MLED_STRIP_N; strip_index++)
+    {
+        if(lights_zones[strip_index].tx_pending || lights_zones[strip_index].dither_n) return true;
+    }
+
+    return false;
 }
 
 void lights_set_strip_size(size_t strip_index, size_t pixel_n)
 {
     ERR_CHECK_RETURN(MLED_STRIP_N <= strip_index);
     mled_strip *strip = &mled_channels[strip_index];
-    ERR_CHECK_RETURN(lights_zones[strip_index].first);
+    lights_zone_list *list = &lights_zones[strip_index];
+    ERR_CHECK_RETURN(list->first);
+
+    /* the last entry is the full output after the LUT built */
+    if(!gamma_lut[LIGHTS_GAMMA_LUT_N - 1]) lights_set_gamma(LIGHTS_GAMMA);
+
     mled_set_size(strip, pixel_n);
+    free(list->frame);
+    list->frame_sent = false;
+    list->dither_n = 0;
+    list->tx_pending = false;
+    list->frame = (uint16_t*)calloc(pixel_n * LIGHTS_CH_N, sizeof(uint16_t));
+    ERR_IF_NULL_RETURN(list->frame);
+}
+
+void lights_set_gamma(float gamma)
+{
+    ERR_CHECK_RETURN(!(gamma > 0));
+
+    for(size_t i = 0; i < LIGHTS_GAMMA_LUT_N; i++)
+    {
+        /* full scale is 255.0 in 8.8, so the output never overflows with the dither added */
+        gamma_lut[i] = lrintf(powf(i / (float)(LIGHTS_GAMMA_LUT_N - 1), gamma) * 255.0f * 256.0f);
+    }
+
+    gamma_cur = gamma;
+    ESP_LOGI(TAG, "gamma %.2f", gamma);
+}
+
+float lights_get_gamma()
+{
+    return gamma_cur;
+}
+
+void lights_get_tx_stat(size_t strip_index, lights_tx_stat *stat, bool reset)
+{
+    ERR_CHECK_RETURN(MLED_STRIP_N <= strip_index);
+    lights_zone_list *list = &lights_zones[strip_index];
+    *stat = list->tx_stat;
+
+    if(reset) list->tx_stat = (lights_tx_stat) {0};
 }
 
 lights_zone_chain *lights_new_zone(size_t strip_index, size_t pixel_n)
@@ -93,14 +202,13 @@ lights_zone_chain *lights_new_zone(size_t strip_index, size_t pixel_n)
     mled_strip *strip = &mled_channels[strip_index];
     lights_zone_list *list = &lights_zones[strip_index];
     mled_pixels *pixels = &strip->pixels;
-    ERR_CHECK_RETURN_VAL(!pixels->data, NULL);
+    ERR_CHECK_RETURN_VAL(!list->frame, NULL);
     ERR_CHECK_RETURN_VAL(!pixels->pixel_n, NULL);
     ERR_CHECK_RETURN_VAL(pixel_n > (pixels->pixel_n - list->pixel_used_pos), NULL);
     lights_zone_chain *zone = calloc(1, sizeof(lights_zone_chain));
     ERR_IF_NULL_RETURN_VAL(zone, NULL);
-    zone->frame_buf.data = &pixels->data[list->pixel_used_pos * 3];
+    zone->frame_buf.data = &list->frame[list->pixel_used_pos * LIGHTS_CH_N];
     zone->frame_buf.pixel_n = pixel_n;
-    zone->frame_buf.data_size = pixel_n * 3;
     zone->mled = strip;
 
     if(list->last) list->last->next = zone;
@@ -127,33 +235,39 @@ lights_zone_chain *lights_new_zone(size_t strip_index, size_t pixel_n)
 
 void lights_shader_init_fft(lights_zone_chain *zone)
 {
-    mled_pixels *frame_buf = &zone->frame_buf;
+    lights_frame_buf *frame_buf = &zone->frame_buf;
     lights_shader_cfg_fft *cfg = &zone->shader.cfg.shader_fft;
     ERR_CHECK(2 > frame_buf->pixel_n);
     ERR_IF_NULL_RETURN(cfg->colors);
+    /* init again after a config change */
+    free(cfg->bands);
+    free(cfg->palette);
+    free(cfg->levels);
+    cfg->palette = NULL;
+    cfg->levels = (uint8_t*)malloc(frame_buf->pixel_n);
+    ERR_IF_NULL_RETURN(cfg->levels);
+    memset(cfg->levels, LIGHTS_FFT_LEVEL_NONE, frame_buf->pixel_n);
     cfg->bands = (lights_shader_cfg_fft_band*)malloc(frame_buf->pixel_n * sizeof(lights_shader_cfg_fft_band));
     ERR_IF_NULL_RETURN(cfg->bands);
-    cfg->pixel_lut = (color_hsl*)malloc(frame_buf->pixel_n * sizeof(color_hsl));
-    ERR_IF_NULL_RETURN(cfg->pixel_lut);
-    fft_fadeing(cfg, frame_buf->pixel_n);
     fft_band_map(zone);
+
+    if(fft_palette_bake(cfg, frame_buf->pixel_n)) ESP_LOGI(TAG, "fft palette baked: %d levels", LIGHTS_FFT_LEVEL_N);
 }
 
 static void lights_render_shader_color(lights_zone_chain *zone, bool *update_mled)
 {
-    mled_pixels *frame_buf = &zone->frame_buf;
-    uint8_t *buf = frame_buf->data;
+    lights_frame_buf *frame_buf = &zone->frame_buf;
+    uint16_t *buf = frame_buf->data;
     ERR_IF_NULL_RETURN(buf);
-    mled_rgb_order offset = zone->mled->rgb_order;
     lights_shader_cfg_single *cfg = &zone->shader.cfg.shader_single;
     color_rgb color = cfg->color;
 
     for(size_t i = 0; i < frame_buf->pixel_n; i++)
     {
-        buf[offset.i_r] = color.r;
-        buf[offset.i_g] = color.g;
-        buf[offset.i_b] = color.b;
-        buf += 3;
+        buf[LIGHTS_CH_R] = LIGHTS_U8_TO_U16(color.r);
+        buf[LIGHTS_CH_G] = LIGHTS_U8_TO_U16(color.g);
+        buf[LIGHTS_CH_B] = LIGHTS_U8_TO_U16(color.b);
+        buf += LIGHTS_CH_N;
     }
 
     *update_mled = true;
@@ -161,10 +275,9 @@ static void lights_render_shader_color(lights_zone_chain *zone, bool *update_mle
 
 static void lights_render_shader_repeat(lights_zone_chain *zone, bool *update_mled)
 {
-    mled_pixels *frame_buf = &zone->frame_buf;
-    uint8_t *buf = frame_buf->data;
+    lights_frame_buf *frame_buf = &zone->frame_buf;
+    uint16_t *buf = frame_buf->data;
     ERR_IF_NULL_RETURN(buf);
-    mled_rgb_order offset = zone->mled->rgb_order;
     lights_shader_cfg_repeat *cfg = &zone->shader.cfg.shader_repeat;
     color_rgb *color = cfg->colors;
     ERR_IF_NULL_RETURN(color);
@@ -172,10 +285,10 @@ static void lights_render_shader_repeat(lights_zone_chain *zone, bool *update_ml
 
     for(size_t i = 0; i < frame_buf->pixel_n; i++)
     {
-        buf[offset.i_r] = color->r;
-        buf[offset.i_g] = color->g;
-        buf[offset.i_b] = color->b;
-        buf += 3;
+        buf[LIGHTS_CH_R] = LIGHTS_U8_TO_U16(color->r);
+        buf[LIGHTS_CH_G] = LIGHTS_U8_TO_U16(color->g);
+        buf[LIGHTS_CH_B] = LIGHTS_U8_TO_U16(color->b);
+        buf += LIGHTS_CH_N;
 
         if(cfg->color_n <= ++cur_color)
         {
@@ -190,10 +303,9 @@ static void lights_render_shader_repeat(lights_zone_chain *zone, bool *update_ml
 
 static void lights_render_shader_fade(lights_zone_chain *zone, bool *update_mled)
 {
-    mled_pixels *frame_buf = &zone->frame_buf;
-    uint8_t *buf = frame_buf->data;
+    lights_frame_buf *frame_buf = &zone->frame_buf;
+    uint16_t *buf = frame_buf->data;
     ERR_IF_NULL_RETURN(buf);
-    mled_rgb_order offset = zone->mled->rgb_order;
     lights_shader_cfg_fade *cfg = &zone->shader.cfg.shader_fade;
     color_hsl *color = cfg->colors;
     ERR_IF_NULL_RETURN(color);
@@ -204,8 +316,7 @@ static void lights_render_shader_fade(lights_zone_chain *zone, bool *update_mled
         .pixel_n = frame_buf->pixel_n,
         .ctx = {
             .shader_fade = {
-                .buf = buf,
-                .offset = offset
+                .buf = buf
             }
         }
     };
@@ -215,29 +326,32 @@ static void lights_render_shader_fade(lights_zone_chain *zone, bool *update_mled
 
 static void lights_render_shader_fft(lights_zone_chain *zone, bool *update_mled)
 {
-    mled_pixels *frame_buf = &zone->frame_buf;
-    uint8_t *buf = frame_buf->data;
+    lights_frame_buf *frame_buf = &zone->frame_buf;
+    uint16_t *buf = frame_buf->data;
     ERR_IF_NULL_RETURN(buf);
-    mled_rgb_order offset = zone->mled->rgb_order;
     lights_shader_cfg_fft *cfg = &zone->shader.cfg.shader_fft;
     ERR_IF_NULL_RETURN(cfg->bands);
-    ERR_IF_NULL_RETURN(cfg->pixel_lut);
-    color_hsl *color = cfg->pixel_lut;
-    color_hsl mod;
-    color_rgb rgb;
+    ERR_IF_NULL_RETURN(cfg->palette);
+    ERR_IF_NULL_RETURN(cfg->levels);
+    color_rgb *ramp = cfg->palette;
+    color_rgb *rgb;
     float *fft_res = dsp_fft_get_res(cfg->is_right);
     lights_shader_cfg_fft_band *band = cfg->bands;
-    float rms;
+    float level;
     float fft_val;
     float corr;
+    float level_max = (LIGHTS_FFT_LEVEL_N - 1) * cfg->intensity;
+    uint8_t level_i = LIGHTS_FFT_LEVEL_N - 1;
+    bool dirty = false;
 
-    if(cfg->mirror) buf += frame_buf->data_size - 3;
+    if(cfg->mirror) buf += (frame_buf->pixel_n - 1) * LIGHTS_CH_N;
 
-    if(fft_res)
+    for(size_t px_i = 0; px_i < frame_buf->pixel_n; px_i++)
     {
-        for(size_t px_i = 0; px_i < frame_buf->pixel_n; px_i++)
+        /* without audio analysis the pixel colors at full level */
+        if(fft_res)
         {
-            rms = 0;
+            level = 0;
 
             for(size_t fft_i = band->fft_min; fft_i < band->fft_max; fft_i++)
             {
@@ -247,48 +361,38 @@ static void lights_render_shader_fft(lights_zone_chain *zone, bool *update_mled)
                 corr = (fft_i * 99.0f);
                 corr /= (float)DSP_FFT_RES_N;
                 fft_val *= 1.0f + corr;
-                rms += powf(fft_val, 2.0f);
+                level += fft_val * fft_val;
             }
 
-            rms = sqrtf(rms / (float)band->fft_width);
-            /* apply LED brightness rough gamma correction */
-            rms *= rms;
-            mod = *color;
-            mod.lum *= rms * cfg->intensity;
-
-            if(mod.lum > color->lum) mod.lum = color->lum;
-            else if(mod.lum < 0) mod.lum = 0;
-
-            rgb = color_hsl_to_rgb(mod);
-            buf[offset.i_r] = rgb.r;
-            buf[offset.i_g] = rgb.g;
-            buf[offset.i_b] = rgb.b;
+            /* rms to the nearest baked level of the pixel,
+             * the LED brightness gamma is applied by the output stage */
+            level = sqrtf(level / (float)band->fft_width) * level_max;
 
-            if(cfg->mirror) buf -= 3;
-            else buf += 3;
+            if(level > (LIGHTS_FFT_LEVEL_N - 1)) level = LIGHTS_FFT_LEVEL_N - 1;
+            else if(level < 0) level = 0;
 
-            color++;
-            band++;
+            level_i = lrintf(level);
         }
-    }
-    else
-    {
-        for(size_t px_i = 0; px_i < frame_buf->pixel_n; px_i++)
-        {
-            rgb = color_hsl_to_rgb(*color);
-            buf[offset.i_r] = rgb.r;
-            buf[offset.i_g] = rgb.g;
-            buf[offset.i_b] = rgb.b;
-
-            if(cfg->mirror) buf -= 3;
-            else buf += 3;
 
-            color++;
+        /* the frame buffer keeps the unchanged pixels */
+        if(cfg->levels[px_i] != level_i)
+        {
+            cfg->levels[px_i] = level_i;
+            rgb = &ramp[level_i];
+            buf[LIGHTS_CH_R] = LIGHTS_U8_TO_U16(rgb->r);
+            buf[LIGHTS_CH_G] = LIGHTS_U8_TO_U16(rgb->g);
+            buf[LIGHTS_CH_B] = LIGHTS_U8_TO_U16(rgb->b);
+            dirty = true;
         }
 
+        if(cfg->mirror) buf -= LIGHTS_CH_N;
+        else buf += LIGHTS_CH_N;
+
+        ramp += LIGHTS_FFT_LEVEL_N;
+        band++;
     }
 
-    *update_mled = true;
+    if(dirty) *update_mled = true;
     /* to keep fft rendering live */
     zone->shader.need_render = true;
 }
@@ -343,16 +447,15 @@ static void fadeing(fading_ctx arg)
             {
                 case FADING_TYPE_SHADER_FADE: {
                     color_rgb rgb = color_hsl_to_rgb(work);
-                    mled_rgb_order offset = arg.ctx.shader_fade.offset;
-                    uint8_t *buf = arg.ctx.shader_fade.buf;
-                    buf[offset.i_r] = rgb.r;
-                    buf[offset.i_g] = rgb.g;
-                    buf[offset.i_b] = rgb.b;
-                    arg.ctx.shader_fade.buf += 3;
+                    uint16_t *buf = arg.ctx.shader_fade.buf;
+                    buf[LIGHTS_CH_R] = LIGHTS_U8_TO_U16(rgb.r);
+                    buf[LIGHTS_CH_G] = LIGHTS_U8_TO_U16(rgb.g);
+                    buf[LIGHTS_CH_B] = LIGHTS_U8_TO_U16(rgb.b);
+                    arg.ctx.shader_fade.buf += LIGHTS_CH_N;
                     break;
                 }
                 case FADING_TYPE_SHADER_FFT: {
-                    *arg.ctx.shader_fft.lut_pos++ = work;
+                    *arg.ctx.shader_fft.lut_pos++ = color_hsl_to_fix(work);
                     break;
                 }
                 default:
@@ -370,7 +473,7 @@ static void fadeing(fading_ctx arg)
     }
 }
 
-static void fft_fadeing(lights_shader_cfg_fft *cfg, size_t pixel_n)
+static void fft_fadeing(lights_shader_cfg_fft *cfg, color_hsl_fix *pixel_lut, size_t pixel_n)
 {
     fading_ctx arg = {
         .type = FADING_TYPE_SHADER_FFT,
@@ -379,7 +482,7 @@ static void fft_fadeing(lights_shader_cfg_fft *cfg, size_t pixel_n)
         .pixel_n = pixel_n,
         .ctx = {
             .shader_fft = {
-                .lut_pos = cfg->pixel_lut
+                .lut_pos = pixel_lut
             }
         }
     };
@@ -419,13 +522,27 @@ static void fft_band_map(lights_zone_chain *zone)
                 width = 1;
             }
 
+            /* more pixels than FFT values: the rest share the top value */
+            if(cur_max > fft_n)
+            {
+                cur_max = fft_n;
+                bands->fft_min = fft_n - 1;
+                width = 1;
+            }
+
             last_max = cur_max;
             bands->fft_max = cur_max;
         }
         else
         {
             /* last item corrected with actual step summary */
-            width = fft_n - sum;
+            if(fft_n > (sum + 1)) width = fft_n - sum;
+            else
+            {
+                bands->fft_min = fft_n - 1;
+                width = 1;
+            }
+
             bands->fft_max = fft_n;
         }
 
@@ -449,3 +566,183 @@ static void fft_band_map(lights_zone_chain *zone)
 
     // ESP_LOGW(TAG, LOG_COLOR_E"SUM: %d", sum);
 }
+
+/* the pixel colors of the fading, then each scaled in lightness to the levels:
+ * palette[pixel * LIGHTS_FFT_LEVEL_N + level], level 0 is black */
+static bool fft_palette_bake(lights_shader_cfg_fft *cfg, size_t pixel_n)
+{
+    color_hsl_fix *pixel_lut = (color_hsl_fix*)malloc(pixel_n * sizeof(color_hsl_fix));
+    ERR_IF_NULL_RETURN_VAL(pixel_lut, false);
+    color_hsl_fix levels[LIGHTS_FFT_LEVEL_N];
+    cfg->palette = (color_rgb*)malloc(pixel_n * LIGHTS_FFT_LEVEL_N * sizeof(color_rgb));
+
+    if(!cfg->palette)
+    {
+        free(pixel_lut);
+        ERR_IF_NULL_RETURN_VAL(cfg->palette, false);
+    }
+
+    fft_fadeing(cfg, pixel_lut, pixel_n);
+
+    for(size_t px_i = 0; px_i < pixel_n; px_i++)
+    {
+        for(size_t level = 0; level < LIGHTS_FFT_LEVEL_N; level++)
+        {
+            levels[level] = pixel_lut[px_i];
+            levels[level].lum = (pixel_lut[px_i].lum * level + ((LIGHTS_FFT_LEVEL_N - 1) / 2)) / (LIGHTS_FFT_LEVEL_N - 1);
+        }
+
+        color_hsl_fix_to_rgb_n(levels, &cfg->palette[px_i * LIGHTS_FFT_LEVEL_N], LIGHTS_FFT_LEVEL_N);
+    }
+
+    free(pixel_lut);
+    return true;
+}
+
+/* dither value of the first channel in this output, 128 (rounding) after the cycle */
+static uint8_t lights_dither_start(lights_zone_list *list)
+{
+#if LIGHTS_DITHER
+    /* the last frame of the cycle is rounded and held */
+    if(!list->dither_n || !--list->dither_n) return 128;
+
+    /* bit reversed frame counter: the dither of a channel walks [0..255]
+     * evenly in every 2^n frames, so the average is the exact value */
+    uint8_t dither = list->frame_n++;
+    dither = ((dither & 0xF0) >> 4) | ((dither & 0x0F) << 4);
+    dither = ((dither & 0xCC) >> 2) | ((dither & 0x33) << 2);
+    dither = ((dither & 0xAA) >> 1) | ((dither & 0x55) << 1);
+    return dither;
+#else
+    return 128;
+#endif
+}
+
+bool lights_output(lights_zone_list *list, mled_strip *strip)
+{
+    if(MLED_TYPE_APA102 == strip->type) return lights_output_apa102(list, strip);
+
+    const uint16_t *src = list->frame;
+    uint8_t *dst = strip->pixels.data;
+    uint8_t *sent = strip->pixels.sent;
+    ERR_IF_NULL_RETURN_VAL(src, false);
+    ERR_IF_NULL_RETURN_VAL(dst, false);
+    ERR_IF_NULL_RETURN_VAL(sent, false);
+    mled_rgb_order format = strip->rgb_order;
+    size_t pixel_size = MLED_PIXEL_SIZE(format);
+    uint32_t ch[LIGHTS_CH_N];
+    uint32_t wire[MLED_PIXEL_SIZE_MAX];
+    uint32_t white;
+    uint8_t out;
+    uint32_t fraction = 0;
+    /* the first frame sent anyway, the strip state unknown before */
+    bool changed = !list->frame_sent;
+    list->frame_sent = true;
+    uint8_t dither = lights_dither_start(list);
+    /* the held frame after the cycle only rounded, without the pattern */
+    uint8_t dither_step = list->dither_n ? LIGHTS_DITHER_STEP : 0;
+
+    for(size_t px = 0; px < strip->pixels.pixel_n; px++)
+    {
+        for(uint8_t i = 0; i < LIGHTS_CH_N; i++)
+        {
+            ch[i] = gamma_lut[*src++ >> (16 - LIGHTS_GAMMA_LUT_BITS)];
+        }
+
+        /* RGBW: the common part of the channels goes to the white LED,
+         * in linear light (after the gamma), so the color stays the same */
+        if(format.white)
+        {
+            white = ch[LIGHTS_CH_R];
+
+            if(ch[LIGHTS_CH_G] < white) white = ch[LIGHTS_CH_G];
+            if(ch[LIGHTS_CH_B] < white) white = ch[LIGHTS_CH_B];
+
+            wire[format.i_w] = white;
+            ch[LIGHTS_CH_R] -= white;
+            ch[LIGHTS_CH_G] -= white;
+            ch[LIGHTS_CH_B] -= white;
+        }
+
+        wire[format.i_r] = ch[LIGHTS_CH_R];
+        wire[format.i_g] = ch[LIGHTS_CH_G];
+        wire[format.i_b] = ch[LIGHTS_CH_B];
+
+        /* dithered in the wire byte order, compared with the last sent frame instead of a hash */
+        for(uint8_t i = 0; i < pixel_size; i++)
+        {
+            out = (wire[i] + dither) >> 8;
+            fraction |= wire[i];
+            dither += dither_step;
+            changed |= (*sent++ != out);
+            *dst++ = out;
+        }
+    }
+
+    /* no fraction: the dithered frames would be the same */
+    if(!(fraction & 0xFF)) list->dither_n = 0;
+
+    return changed;
+}
+
+/* clocked strips: the lowest 5 bit pixel brightness which still fits the brightest
+ * channel, then the channels scaled up to it, the dim pixels keep ~5 bits more levels */
+static bool lights_output_apa102(lights_zone_list *list, mled_strip *strip)
+{
+    const uint16_t *src = list->frame;
+    uint8_t *dst = strip->pixels.data;
+    const uint8_t *sent = strip->pixels.sent;
+    ERR_IF_NULL_RETURN_VAL(src, false);
+    ERR_IF_NULL_RETURN_VAL(dst, false);
+    ERR_IF_NULL_RETURN_VAL(sent, false);
+    mled_rgb_order format = strip->rgb_order;
+    uint32_t ch[LIGHTS_CH_N];
+    uint32_t wire[LIGHTS_CH_N];
+    uint32_t max;
+    uint32_t bri;
+    uint32_t scaled;
+    uint8_t out;
+    uint32_t fraction = 0;
+    bool changed = !list->frame_sent;
+    list->frame_sent = true;
+    uint8_t dither = lights_dither_start(list);
+    /* the held frame after the cycle only rounded, without the pattern */
+    uint8_t dither_step = list->dither_n ? LIGHTS_DITHER_STEP : 0;
+
+    for(size_t px = 0; px < strip->pixels.pixel_n; px++)
+    {
+        for(uint8_t i = 0; i < LIGHTS_CH_N; i++)
+        {
+            ch[i] = gamma_lut[*src++ >> (16 - LIGHTS_GAMMA_LUT_BITS)];
+        }
+
+        max = ch[LIGHTS_CH_R];
+
+        if(ch[LIGHTS_CH_G] > max) max = ch[LIGHTS_CH_G];
+        if(ch[LIGHTS_CH_B] > max) max = ch[LIGHTS_CH_B];
+
+        bri = lights_apa102_bri(max);
+        out = MLED_APA102_HEADER | bri;
+        changed |= (*sent++ != out);
+        *dst++ = out;
+        /* the color bytes after the brightness in the order of the strip */
+        wire[format.i_r] = ch[LIGHTS_CH_R];
+        wire[format.i_g] = ch[LIGHTS_CH_G];
+        wire[format.i_b] = ch[LIGHTS_CH_B];
+
+        for(uint8_t i = 0; i < LIGHTS_CH_N; i++)
+        {
+            scaled = lights_apa102_scale(wire[i], bri);
+            out = (scaled + dither) >> 8;
+            fraction |= scaled;
+            changed |= (*sent++ != out);
+            *dst++ = out;
+            dither += dither_step;
+        }
+    }
+
+    /* no fraction: the dithered frames would be the same */
+    if(!(fraction & 0xFF)) list->dither_n = 0;
+
+    return changed;
+}
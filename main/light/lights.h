@@ -12,6 +12,13 @@
 #include "color.h"
 
 
+/* the frame buffer pixel, the shaders need not know the strip pixel format */
+#define LIGHTS_CH_R 0
+#define LIGHTS_CH_G 1
+#define LIGHTS_CH_B 2
+#define LIGHTS_CH_N 3
+
+
 typedef enum {
     SHADER_SINGLE,
     SHADER_REPEAT,
@@ -44,7 +51,8 @@ typedef struct {
     size_t color_n;
     lights_shader_cfg_fft_band *bands;
     bool is_right; // audio channel
-    color_hsl *pixel_lut; // store each pixel color
+    color_rgb *palette; // LIGHTS_FFT_LEVEL_N brightness levels of each pixel color
+    uint8_t *levels; // last rendered level of each pixel, for the dirty tracking
     float intensity;
     bool mirror;
 } lights_shader_cfg_fft;
@@ -61,28 +69,74 @@ typedef struct {
     } cfg;
 } lights_shader;
 
+/* 16 bit per channel in R, G, B order for every strip, before the output stage
+ * (gamma correction, white extraction and dithering to the pixel format of the strip) */
+typedef struct {
+    uint16_t *data;
+    size_t pixel_n;
+} lights_frame_buf;
+
 typedef struct {
     mled_strip *mled;
-    mled_pixels frame_buf;
+    lights_frame_buf frame_buf;
     lights_shader shader;
     void *next;
 } lights_zone_chain;
 
+typedef struct {
+    uint32_t sent; // frames given to mled_update
+    uint32_t skipped; // rendered, but the same as the last sent frame, so not sent
+} lights_tx_stat;
+
 typedef struct {
     lights_zone_chain *first;
     lights_zone_chain *last;
     size_t zone_n;
     size_t pixel_used_pos;
+    uint16_t *frame; // frame buffer of the whole strip, shared by the zones
+    uint8_t frame_n; // output frame counter, selects the dither pattern
+    bool frame_sent; // any frame sent since the strip size set
+    uint16_t dither_n; // outputs left of the dither cycle, the last one rounded and held
+    bool tx_pending; // the output waits in the back buffer for the strip
+    lights_tx_stat tx_stat;
 } lights_zone_list;
 
 
 extern lights_zone_list lights_zones[MLED_STRIP_N];
 
 
-void lights_main();
+/* clocked strips: the lowest 5 bit pixel brightness at which the brightest 8.8 channel
+ * still fits the LUT full scale (255.0) scaled up, with the dither it fits 16 bit,
+ * the scale truncates: (max * 31) / bri <= 255.0 while max * 31 < bri * (255.0 + 1) */
+static inline uint32_t lights_apa102_bri(uint32_t max)
+{
+    return max ? ((max * MLED_APA102_BRIGHTNESS_MAX) / (255 * 256 + 1)) + 1 : 0;
+}
+
+/* an 8.8 channel scaled up to the pixel brightness of lights_apa102_bri */
+static inline uint32_t lights_apa102_scale(uint32_t ch, uint32_t bri)
+{
+    return bri ? (ch * MLED_APA102_BRIGHTNESS_MAX) / bri : 0;
+}
+
+
+/* render the zones need it, true if any zone needs render in the next frame too */
+bool lights_main();
+/* true while a strip frame waits for its transmit or the output dither cycle runs,
+ * lights_main has to be called again even without any render */
+bool lights_busy();
 void lights_set_strip_size(size_t strip_index, size_t pixel_n);
 lights_zone_chain *lights_new_zone(size_t strip_index, size_t pixel_n);
 void lights_shader_init_fft(lights_zone_chain *zone);
+/* output gamma (1.0: none), the value sent to the strip is the rendered one ^ gamma */
+void lights_set_gamma(float gamma);
+float lights_get_gamma();
+/* gamma correction and dithering of the strip frame to the strip pixels (lights_main
+ * calls it for the changed strips), one table lookup plus add per channel,
+ * false if the pixels not changed */
+bool lights_output(lights_zone_list *list, mled_strip *strip);
+/* reset: clear the counters after */
+void lights_get_tx_stat(size_t strip_index, lights_tx_stat *stat, bool reset);
 
 
 #endif /* __LIGHTS__ */
@@ -1,8 +1,18 @@
 
+#include "stdlib.h"
+
+#include "esp_attr.h"
+
 #include "app_tools.h"
 #include "led_matrix.h"
 
 
+/* RMT symbols of one nibble, MSB first */
+#define WS281X_NIBBLE_SYMBOL_N 4
+/* RMT symbols of one byte */
+#define WS281X_BYTE_SYMBOL_N (WS281X_NIBBLE_SYMBOL_N * 2)
+
+
 static const char *TAGE = "WS281x";
 /* from WS281x cascade RGB LED chip datasheet:
  *
@@ -16,7 +26,7 @@ static const char *TAGE = "WS281x";
  *  |       T1H: 580ns~1.6µs       |                  |
  *  |______________________________| T1L: 220ns~420ns |
  */
-static const rmt_bytes_encoder_config_t ws281x_encoder_cfg = {
+const rmt_bytes_encoder_config_t mled_ws281x_encoder_cfg = {
     .bit0 = { // 0 code, if bit is set
         .level0 = 1,
         .duration0 = MLED_NS_TO_DURATION(270), // T0H
@@ -31,6 +41,11 @@ static const rmt_bytes_encoder_config_t ws281x_encoder_cfg = {
     },
     .flags.msb_first = 1 // WS281x require high bit data is first: 7 -> 0
 };
+#if MLED_WS281X_LUT
+/* the symbols of every nibble value, built from the bit codes above,
+ * in DRAM: the RMT ISR reads it, also while the flash cache is disabled */
+static DRAM_ATTR rmt_symbol_word_t ws281x_nibble_lut[16][WS281X_NIBBLE_SYMBOL_N];
+#endif
 static const rmt_symbol_word_t ws281x_reset_code = {
     .level0 = 0,
     .duration0 = MLED_US_TO_DURATION(300), // reset time in WS281x need >280µs
@@ -41,8 +56,20 @@ static const rmt_symbol_word_t ws281x_reset_code = {
 
 void mled_encode_chain_ws281x(mled_strip *strip)
 {
+#if MLED_WS281X_LUT
+    mled_ws281x_lut_build();
+
+    /* simple encoder, the callback fills the RMT memory with whole bytes */
+    rmt_simple_encoder_config_t simple_encoder_cfg = {
+        .callback = mled_ws281x_encode,
+        .arg = NULL,
+        .min_chunk_size = WS281X_BYTE_SYMBOL_N
+    };
+    ERR_CHECK_RESET(rmt_new_simple_encoder(&simple_encoder_cfg, &strip->payload_handler));
+#else
     /* byte encoder used to transform 1 bit to "0 code" and "1 code" for WS281x */
-    ERR_CHECK_RESET(rmt_new_bytes_encoder(&ws281x_encoder_cfg, &strip->payload_handler));
+    ERR_CHECK_RESET(rmt_new_bytes_encoder(&mled_ws281x_encoder_cfg, &strip->payload_handler));
+#endif
 
     /* copy encoder used for send WS281x "reset code" (time, while low level needed) */
     rmt_copy_encoder_config_t copy_encoder_cfg;
@@ -51,3 +78,49 @@ void mled_encode_chain_ws281x(mled_strip *strip)
     strip->reset_code = &ws281x_reset_code;
     strip->reset_code_size = sizeof(ws281x_reset_code);
 }
+
+#if MLED_WS281X_LUT
+void mled_ws281x_lut_build()
+{
+    for(uint8_t nibble = 0; nibble < 16; nibble++)
+    {
+        for(uint8_t bit = 0; bit < WS281X_NIBBLE_SYMBOL_N; bit++)
+        {
+            ws281x_nibble_lut[nibble][bit] = (nibble & (0x08 >> bit)) ? mled_ws281x_encoder_cfg.bit1 : mled_ws281x_encoder_cfg.bit0;
+        }
+    }
+}
+
+/* called from the RMT ISR with the free part of the channel memory,
+ * symbols_written tells where the last call stopped in the data */
+size_t IRAM_ATTR mled_ws281x_encode(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free, rmt_symbol_word_t *symbols, bool *done, void *arg)
+{
+    size_t byte_i = symbols_written / WS281X_BYTE_SYMBOL_N;
+    size_t byte_n = symbols_free / WS281X_BYTE_SYMBOL_N;
+    const uint8_t *byte = (const uint8_t*)data + byte_i;
+    const rmt_symbol_word_t *high;
+    const rmt_symbol_word_t *low;
+
+    if(byte_n > (data_size - byte_i)) byte_n = data_size - byte_i;
+
+    for(size_t i = 0; i < byte_n; i++, byte++)
+    {
+        high = ws281x_nibble_lut[*byte >> 4];
+        low = ws281x_nibble_lut[*byte & 0x0F];
+        /* the RMT memory takes only word access */
+        symbols[0].val = high[0].val;
+        symbols[1].val = high[1].val;
+        symbols[2].val = high[2].val;
+        symbols[3].val = high[3].val;
+        symbols[4].val = low[0].val;
+        symbols[5].val = low[1].val;
+        symbols[6].val = low[2].val;
+        symbols[7].val = low[3].val;
+        symbols += WS281X_BYTE_SYMBOL_N;
+    }
+
+    if(data_size <= (byte_i + byte_n)) *done = true;
+
+    return byte_n * WS281X_BYTE_SYMBOL_N;
+}
+#endif
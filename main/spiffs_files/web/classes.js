@@ -5,7 +5,7 @@ const SHADER_FADE = 2;
 const SHADER_FFT = 3;
 
 const regexNumbers = /[^0-9]+/;
-const regexRGB = /[^RGBrgb]+/;
+const regexRGB = /[^RGBWrgbw]+/;
 
 class Strip {
     constructor(id) {
@@ -55,7 +55,7 @@ class RenderStrip {
         this.stripSizeTyper.onChanged = newVal => this.onSizeTyperDone(newVal);
         this.stripSizeTyper.onFinalCheck = newVal => this.onSizeTyperCheck(newVal);
         let rgbOrderBox = htmlBox.getElementsByClassName("RGBOrderBox")[0];
-        this.rgbOrderTyper = new WriteTyper(rgbOrderBox, regexRGB, 3);
+        this.rgbOrderTyper = new WriteTyper(rgbOrderBox, regexRGB, 4);
         this.rgbOrderTyper.onChanged = newVal => this.onRgbOrderTyperDone(newVal);
         this.rgbOrderTyper.onFinalCheck = newVal => this.onRgbOrderTyperCheck(newVal);
         this.newZoneHidden = true;
@@ -122,7 +122,9 @@ class RenderStrip {
     }
 
     onRgbOrderTyperCheck(newVal) {
-        if(!(newVal.includes('R') && newVal.includes('G') && newVal.includes('B'))) {
+        /* RGB in any order, optionally with W (RGBW strips) */
+        if(!(newVal.includes('R') && newVal.includes('G') && newVal.includes('B'))
+            || (newVal.length != 3 && !(newVal.length == 4 && newVal.includes('W')))) {
             newVal = "RGB";
         }
 
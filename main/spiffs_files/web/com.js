@@ -43,6 +43,18 @@ class MessageHandler {
             case 2:
                 this.clientBound_shaderConfig(u8Array.slice(1));
                 break;
+            case 3:
+                this.clientBound_audioMeter(u8Array.slice(1));
+                break;
+            case 4:
+                this.clientBound_audioProfile(u8Array.slice(1));
+                break;
+            case 5:
+                this.clientBound_profiler(u8Array.slice(1));
+                break;
+            case 6:
+                this.clientBound_instrDump(u8Array.slice(1));
+                break;
             default: console.error(`unknown CID: ${u8Array[0]}`);
         }
     }
@@ -64,6 +76,70 @@ class MessageHandler {
         throw new Error(`nincs lekezelve csoro CID2: ${u8Array}`);
     }
 
+    // CID 3
+    clientBound_audioMeter(u8Array) {
+        /* limiter gain reduction: current (float) + max since last request (float) */
+        let dataView = new DataView(u8Array.buffer);
+        refreshAudioMeter(dataView.getFloat32(0, true), dataView.getFloat32(4, true));
+    }
+
+    // CID 4
+    clientBound_audioProfile(u8Array) {
+        /* selected + active + profile_n * zero ended name */
+        let names = new TextDecoder().decode(u8Array.slice(2)).split("\0");
+        names.pop();
+        refreshAudioProfile(u8Array[0], u8Array[1], names);
+    }
+
+    // CID 5
+    clientBound_profiler(u8Array) {
+        /* heap free (uint32) + heap min free (uint32)
+         * + core_n + core_n * load
+         * + loop_n + loop_n * (miss_n (uint32) + jitter max (uint32) + 16 * histogram count (uint16))
+         * + I2S refill: refill_n (uint32) + latency avg (uint32) + latency max (uint32) + slack min (int32)
+         * + task_n + task_n * (CPU per mille (uint16) + stack min free (uint32) + core + zero ended name) */
+        let dataView = new DataView(u8Array.buffer);
+        let stat = {heapFree: dataView.getUint32(0, true), heapMin: dataView.getUint32(4, true), loads: [], loops: [], refill: null, tasks: []};
+        let i = 8;
+        let n = u8Array[i++];
+
+        for(let j = 0; j < n; j++) stat.loads.push(u8Array[i++]);
+
+        n = u8Array[i++];
+
+        for(let j = 0; j < n; j++) {
+            let loop = {missN: dataView.getUint32(i, true), jitterMax: dataView.getUint32(i + 4, true), hist: []};
+            i += 8;
+
+            for(let k = 0; k < 16; k++, i += 2) loop.hist.push(dataView.getUint16(i, true));
+
+            stat.loops.push(loop);
+        }
+
+        stat.refill = {n: dataView.getUint32(i, true), latencyAvg: dataView.getUint32(i + 4, true),
+            latencyMax: dataView.getUint32(i + 8, true), slackMin: dataView.getInt32(i + 12, true)};
+        i += 16;
+
+        n = u8Array[i++];
+
+        for(let j = 0; j < n; j++) {
+            let task = {cpu: dataView.getUint16(i, true) / 10, stack: dataView.getUint32(i + 2, true), core: u8Array[i + 6]};
+            i += 7;
+            let end = u8Array.indexOf(0, i);
+            task.name = new TextDecoder().decode(u8Array.slice(i, end));
+            i = end + 1;
+            stat.tasks.push(task);
+        }
+
+        refreshProfiler(stat);
+    }
+
+    // CID 6
+    clientBound_instrDump(u8Array) {
+        /* text */
+        refreshInstrDump(new TextDecoder().decode(u8Array));
+    }
+
     tx(packet) {
         try {
             console.log(`kűdés van ${new Uint8Array(packet)}`);
@@ -76,14 +152,14 @@ class MessageHandler {
 
     // SID 0
     serverBound_stripSet(stripIndex, pixelSize, rgbOrder) {
-        /* SID + stripIndex + pixelSize (uint32) + rgbOrder (3 char) */
-        let len = 1 + 1 + 4 + 3;
+        /* SID + stripIndex + pixelSize (uint32) + rgbOrder (4 char, RGB zero padded) */
+        let len = 1 + 1 + 4 + 4;
         let buf = new ArrayBuffer(len);
         let dataView = new DataView(buf);
         dataView.setUint8(0, 0);
         dataView.setUint8(1, stripIndex);
         dataView.setUint32(2, pixelSize);
-        new Uint8Array(buf, 6, 3).set(new TextEncoder().encode(rgbOrder));
+        new Uint8Array(buf, 6, 4).set(new TextEncoder().encode(rgbOrder));
         this.tx(buf);
     }
 
@@ -127,4 +203,32 @@ class MessageHandler {
 
         this.tx(buf);
     }
+
+    // SID 3
+    serverBound_audioMeterGet() {
+        if(ws.ws.readyState != WebSocket.OPEN) return;
+
+        /* SID */
+        let buf = new ArrayBuffer(1);
+        new DataView(buf).setUint8(0, 3);
+        this.tx(buf);
+    }
+
+    // SID 4
+    serverBound_audioProfileSet(profileIndex) {
+        /* SID + profileIndex */
+        let buf = new ArrayBuffer(2);
+        let dataView = new DataView(buf);
+        dataView.setUint8(0, 4);
+        dataView.setUint8(1, profileIndex);
+        this.tx(buf);
+    }
+
+    // SID 5
+    serverBound_instrDump() {
+        /* SID */
+        let buf = new ArrayBuffer(1);
+        new DataView(buf).setUint8(0, 5);
+        this.tx(buf);
+    }
 }
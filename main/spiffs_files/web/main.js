@@ -5,6 +5,13 @@ const tmpStripBox = document.getElementById("tmpStripBox");
 const tmpZoneBox = document.getElementById("tmpZoneBox");
 const tmpStripZoneListItem = document.getElementById("tmpStripZoneListItem");
 const tmpCheckBox = document.getElementById("tmpCheckBox");
+const audioMeterCur = document.getElementById("audioMeterCur");
+const audioMeterMax = document.getElementById("audioMeterMax");
+const audioProfileSelect = document.getElementById("audioProfileSelect");
+const audioProfilePending = document.getElementById("audioProfilePending");
+const profiler = document.getElementById("profiler");
+const instrDump = document.getElementById("instrDump");
+const instrDumpButton = document.getElementById("instrDumpButton");
 const deleteDialog = new DeleteDialog();
 const ws = new WebSocketHandler();
 const com = new MessageHandler();
@@ -17,6 +24,59 @@ function onPageLoaded()
 {
     initColorPickerEventHandlers();
     ws.newSocket();
+    setInterval(() => com.serverBound_audioMeterGet(), 500);
+    audioProfileSelect.onchange = () => com.serverBound_audioProfileSet(audioProfileSelect.selectedIndex);
+    instrDumpButton.onclick = () => com.serverBound_instrDump();
+}
+
+function refreshAudioMeter(curDB, maxDB) {
+    audioMeterCur.textContent = curDB.toFixed(1);
+    audioMeterMax.textContent = maxDB.toFixed(1);
+}
+
+function refreshAudioProfile(selected, active, names) {
+    if(audioProfileSelect.options.length != names.length) {
+        audioProfileSelect.replaceChildren();
+
+        for(let name of names) {
+            let option = document.createElement("option");
+            option.textContent = name.replace("_", " ");
+            audioProfileSelect.appendChild(option);
+        }
+    }
+
+    audioProfileSelect.selectedIndex = selected;
+    /* new buffering applied only after the audio stream ended */
+    audioProfilePending.textContent = (selected != active) ? "(after playing)" : "";
+}
+
+function refreshProfiler(stat) {
+    const LOOP_NAMES = ["DSP", "lights"];
+    let lines = [`heap: ${stat.heapFree} B (min ${stat.heapMin} B), core load: ${stat.loads.join("%, ")}%`];
+
+    stat.loops.forEach((loop, i) => {
+        /* the slowest non-empty histogram bucket: loop time under 2^(k+1) us */
+        let k = loop.hist.findLastIndex((count) => count > 0);
+        lines.push(`${LOOP_NAMES[i] ?? i}: missed ${loop.missN}, jitter max ${loop.jitterMax} us, time max < ${2 ** (k + 1)} us`);
+    });
+
+    /* the audio output deadline: time left before the I2S DMA runs empty */
+    if(stat.refill.n) {
+        lines.push(`I2S refill: ${stat.refill.n}, latency avg ${stat.refill.latencyAvg} us, max ${stat.refill.latencyMax} us, slack min ${stat.refill.slackMin} us`);
+    }
+
+    stat.tasks.sort((a, b) => b.cpu - a.cpu);
+
+    for(let task of stat.tasks) {
+        let core = (task.core < 255) ? task.core : "-";
+        lines.push(`${task.name.padEnd(16)} ${task.cpu.toFixed(1).padStart(5)}%  core ${core}  stack free ${task.stack} B`);
+    }
+
+    profiler.textContent = lines.join("\n");
+}
+
+function refreshInstrDump(text) {
+    instrDump.textContent = text;
 }
 
 function refreshStripConfig(isFirst, data) {
@@ -25,7 +85,7 @@ function refreshStripConfig(isFirst, data) {
     let strip;
     let renderStrip;
     let dataView = new DataView(data.buffer);
-    /* strip_n * (pixel_n + rgb_order) */
+    /* strip_n * (pixel_n + rgb_order), the order is 4 bytes: RGB zero padded or RGBW */
 
     while(dataIndex < (data.length)) {
         if(isFirst) renderStrip = addNewStrip(stripIndex);
@@ -37,9 +97,9 @@ function refreshStripConfig(isFirst, data) {
         strip.pixelSize = dataView.getUint32(dataIndex);
         console.log(`pixel size: ${strip.pixelSize}`);
         dataIndex += 4;
-        strip.rgbOrder = new TextDecoder().decode(data.slice(dataIndex, dataIndex + 3));
+        strip.rgbOrder = new TextDecoder().decode(data.slice(dataIndex, dataIndex + 4)).replace(/\0/g, "");
         console.log(`rgb order: ${strip.rgbOrder}`);
-        dataIndex += 3;
+        dataIndex += 4;
         renderStrip.syncStripData();
         renderStrip.checkCanShowCreate();
         stripIndex++;
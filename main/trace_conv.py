@@ -0,0 +1,109 @@
+import sys
+import json
+import struct
+
+
+# converts the /trace download of the device to Chrome trace / Perfetto JSON
+# usage: python trace_conv.py trace.bin trace.json
+# open the result in chrome://tracing or https://ui.perfetto.dev
+
+TRACE_MAGIC = 0x31435254
+RECORD_FMT = "<IBBH"
+RECORD_SIZE = struct.calcsize(RECORD_FMT)
+
+# same order as trace_event_id in app/trace.h
+TRACE_AUDIO_STATE = 0
+TRACE_RING_FILL = 1
+TRACE_CONCEAL = 2
+TRACE_DSP_BEGIN = 3
+TRACE_DSP_END = 4
+TRACE_LIGHTS_BEGIN = 5
+TRACE_LIGHTS_END = 6
+TRACE_RMT_DONE = 7
+
+# same order as audio_state_t in app/tasks.c
+AUDIO_STATES = ["INIT", "STOP", "READY", "PRELOAD", "PLAY", "DROP", "FLUSH"]
+CONCEAL_TYPES = ["overflow trim", "underrun fill"]
+
+# one timeline row (thread) for each event source
+TIDS = {
+    TRACE_AUDIO_STATE: "audio",
+    TRACE_RING_FILL: "audio",
+    TRACE_CONCEAL: "audio",
+    TRACE_DSP_BEGIN: "dsp",
+    TRACE_DSP_END: "dsp",
+    TRACE_LIGHTS_BEGIN: "lights",
+    TRACE_LIGHTS_END: "lights",
+    TRACE_RMT_DONE: "rmt",
+}
+
+def read_records(data):
+    magic, record_n = struct.unpack_from("<II", data, 0)
+
+    if magic != TRACE_MAGIC:
+        print("not a trace file :(")
+        exit(1)
+
+    records = []
+    time_high = 0
+    time_prev = None
+
+    for i in range(record_n):
+        time_us, event, core, arg = struct.unpack_from(RECORD_FMT, data, 8 + i * RECORD_SIZE)
+
+        # the device time is 32 bit, unwrap it, records of the two cores
+        # can be a little out of order, so only a big jump back is a wrap
+        if time_prev is not None and (time_prev - time_us) > (1 << 31):
+            time_high += 1 << 32
+
+        time_prev = time_us
+        records.append((time_high + time_us, event, core, arg))
+
+    return records
+
+def convert(records):
+    events = []
+    # the timeline starts at the oldest record
+    time_start = records[0][0] if records else 0
+    # an end without begin at the ring start would break the nesting
+    opened = set()
+
+    for time_us, event, core, arg in records:
+        ts = time_us - time_start
+        tid = TIDS.get(event, "unknown")
+        base = {"pid": 0, "tid": tid, "ts": ts, "args": {"core": core}}
+
+        if event == TRACE_AUDIO_STATE:
+            name = AUDIO_STATES[arg] if arg < len(AUDIO_STATES) else str(arg)
+            events.append(dict(base, name="state " + name, ph="i", s="t"))
+        elif event == TRACE_RING_FILL:
+            events.append(dict(base, name="ring fill", ph="C", args={"bytes": arg}))
+        elif event == TRACE_CONCEAL:
+            name = CONCEAL_TYPES[arg] if arg < len(CONCEAL_TYPES) else str(arg)
+            events.append(dict(base, name="conceal " + name, ph="i", s="t"))
+        elif event in (TRACE_DSP_BEGIN, TRACE_LIGHTS_BEGIN):
+            opened.add(tid)
+            events.append(dict(base, name=tid, ph="B"))
+        elif event in (TRACE_DSP_END, TRACE_LIGHTS_END):
+            if tid in opened:
+                opened.discard(tid)
+                events.append(dict(base, name=tid, ph="E"))
+        elif event == TRACE_RMT_DONE:
+            events.append(dict(base, name=f"strip {arg} sent", ph="i", s="t"))
+        else:
+            print(f"unknown event: {event}")
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+if(2 < len(sys.argv)):
+    with open(sys.argv[1], "rb") as file:
+        records = read_records(file.read())
+
+    with open(sys.argv[2], "w+", encoding="utf-8") as file:
+        json.dump(convert(records), file)
+
+    print(f"{len(records)} records converted")
+    exit(0)
+else:
+    print("wrong args :(")
+    exit(1)